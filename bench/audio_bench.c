@@ -0,0 +1,216 @@
+#define _POSIX_C_SOURCE 200809L
+#include "audio.h"
+#include "bot.h"
+#include "profiler.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Audio mixer throughput and drop policy without an audio device. First a
+// burst: triggers posted as fast as one thread can, for the posting cost and
+// what the queue drops. Then a reflex bot swarm game in real time at
+// SIM_TICK_RATE, posting each tick's events like the game does. The player
+// is kept invincible so the swarm keeps raining floor hits, and a collision
+// is posted once a second on top. Plays go through a backend that checks
+// the voice limits: no voice of a sound is played again before its play
+// ends or is stopped, and no more than the mixer's voices sound at once.
+// The game runs twice: with the game's voices, and with fewer than the
+// floor hits alone may hold, where every collision must steal from a floor
+// hit and every stolen voice must be stopped first. Exits non-zero if a
+// limit is broken or, in a swarm, nothing was stolen in the second run
+// (classic mode lands too few obstacles to fill the voices).
+//
+// usage: raylibLearn_audio_bench [seconds] [swarm obstacles] [log file]
+
+#define BURST_TRIGGERS 1000000
+
+#define CONTENDED_VOICES 2
+#define PREROLL_SECONDS 5
+
+typedef struct {
+  AudioBackend inner; // also gets every call, if set
+  int maxVoices;
+  uint64_t voiceEnd[AUDIO_MAX_SOUNDS][AUDIO_MAX_VOICES];
+  long long plays[AUDIO_MAX_SOUNDS];
+  long long stops;
+  long long violations;
+  int peakVoices;
+} CheckedBackend;
+
+static void CheckedPlay(void *context, int sound, int voice) {
+  CheckedBackend *checked = context;
+  uint64_t now = ProfilerNow();
+  if (checked->voiceEnd[sound][voice] > now)
+    checked->violations++;
+  checked->voiceEnd[sound][voice] =
+      now + (uint64_t)(audioGameSounds[sound].durationMs * 1e6f);
+  checked->plays[sound]++;
+
+  int sounding = 0;
+  for (int s = 0; s < SIM_EVENT_COUNT; s++) {
+    for (int v = 0; v < AUDIO_MAX_VOICES; v++)
+      sounding += checked->voiceEnd[s][v] > now;
+  }
+  if (sounding > checked->maxVoices)
+    checked->violations++;
+  if (sounding > checked->peakVoices)
+    checked->peakVoices = sounding;
+  if (checked->inner.play)
+    checked->inner.play(checked->inner.context, sound, voice);
+}
+
+static void CheckedStop(void *context, int sound, int voice) {
+  CheckedBackend *checked = context;
+  checked->voiceEnd[sound][voice] = 0;
+  checked->stops++;
+  if (checked->inner.stop)
+    checked->inner.stop(checked->inner.context, sound, voice);
+}
+
+static void SleepNs(uint64_t ns) {
+  struct timespec ts = {(time_t)(ns / 1000000000ull),
+                        (long)(ns % 1000000000ull)};
+  nanosleep(&ts, NULL);
+}
+
+static void PrintStats(const AudioStats *stats, int maxVoices) {
+  double posted = stats->posted ? (double)stats->posted : 1.0;
+  printf("  posted:         %lld triggers\n", stats->posted);
+  printf("  played:         %lld (%.1f%%)\n", stats->played,
+         100.0 * stats->played / posted);
+  printf("  coalesced:      %lld (%.1f%%)\n", stats->coalesced,
+         100.0 * stats->coalesced / posted);
+  printf("  no voice:       %lld (%.1f%%)\n", stats->voiceDrops,
+         100.0 * stats->voiceDrops / posted);
+  printf("  queue full:     %lld (%.1f%%)\n", stats->queueDrops,
+         100.0 * stats->queueDrops / posted);
+  printf("  stolen:         %lld\n", stats->stolen);
+  printf("  peak voices:    %d of %d\n", stats->peakVoices, maxVoices);
+}
+
+// A real-time game through the checked backend. Returns false if a limit
+// was broken, or if mustSteal and nothing was stolen.
+static bool RunGame(double seconds, int swarm, int maxVoices, FILE *log,
+                    bool mustSteal) {
+  CheckedBackend checked = {.maxVoices = maxVoices};
+  if (log)
+    checked.inner = AudioFileBackend(log);
+  AudioMixer *mixer =
+      AudioMixerOpen(audioGameSounds, SIM_EVENT_COUNT, maxVoices,
+                     (AudioBackend){&checked, CheckedPlay, CheckedStop});
+  GameState game;
+  bool ready = swarm > 0 ? SimInitSwarm(&game, 800, 600, 1, swarm)
+                         : SimInit(&game, 800, 600, 1);
+  if (!mixer || !ready) {
+    fprintf(stderr, "Error starting the mixer and the game\n");
+    exit(1);
+  }
+  game.isInvincible = true;
+  game.invincibilityDuration = INFINITY;
+  // Start once the swarm is landing, not while it is still above the
+  // screen
+  for (int t = 0; t < PREROLL_SECONDS * SIM_TICK_RATE; t++)
+    SimStep(&game, BotReflex(&game), SIM_DT);
+  long long ticks = (long long)(seconds * SIM_TICK_RATE);
+  uint64_t postTotalNs = 0;
+  long long posts = 0;
+  uint64_t start = ProfilerNow();
+  for (long long t = 0; t < ticks; t++) {
+    SimInput input = BotReflex(&game);
+    if (game.gameOver)
+      input |= SIM_INPUT_RESTART;
+    SimStep(&game, input, SIM_DT);
+    // Half a second in, so the floor hits hold the voices by the first
+    if (t % SIM_TICK_RATE == SIM_TICK_RATE / 2)
+      game.events[SIM_EVENT_COLLISION]++;
+    for (int event = 0; event < SIM_EVENT_COUNT; event++) {
+      if (!game.events[event])
+        continue;
+      uint64_t postStart = ProfilerNow();
+      AudioPost(mixer, event, game.events[event]);
+      postTotalNs += ProfilerNow() - postStart;
+      posts++;
+    }
+    uint64_t next = start + (uint64_t)(t + 1) * 1000000000ull / SIM_TICK_RATE;
+    uint64_t now = ProfilerNow();
+    if (next > now)
+      SleepNs(next - now);
+  }
+  AudioStats stats;
+  AudioMixerClose(mixer, &stats);
+  double elapsed = (ProfilerNow() - start) / 1e9;
+  SimFree(&game);
+
+  printf("%lld ticks of a %s game with %d voices in %.1f s:\n", ticks,
+         swarm > 0 ? "swarm" : "classic", maxVoices, elapsed);
+  printf("  triggers:       %.1f/s\n", stats.posted / elapsed);
+  printf("  post:           %.1f ns/event\n",
+         posts ? (double)postTotalNs / posts : 0.0);
+  PrintStats(&stats, maxVoices);
+  printf("  plays:          %lld floor hit, %lld power-up, %lld collision\n",
+         checked.plays[SIM_EVENT_FLOOR_HIT], checked.plays[SIM_EVENT_POWERUP],
+         checked.plays[SIM_EVENT_COLLISION]);
+
+  if (checked.violations) {
+    fprintf(stderr, "%lld plays broke a voice limit\n", checked.violations);
+    return false;
+  }
+  if (checked.stops != stats.stolen) {
+    fprintf(stderr, "%lld voices stolen but %lld stopped\n", stats.stolen,
+            checked.stops);
+    return false;
+  }
+  if (mustSteal && stats.stolen == 0) {
+    fprintf(stderr, "nothing was stolen with %d voices\n", maxVoices);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+  int swarm = argc > 2 ? atoi(argv[2]) : SIM_SWARM_OBSTACLES;
+  const char *logPath = argc > 3 ? argv[3] : NULL;
+  if (seconds <= 0.0) {
+    fprintf(stderr, "seconds must be positive\n");
+    return 1;
+  }
+
+  // Burst: the posting cost and the queue bound
+  AudioNullCounts counts = {0};
+  AudioMixer *mixer = AudioMixerOpen(audioGameSounds, SIM_EVENT_COUNT,
+                                     AUDIO_GAME_VOICES,
+                                     AudioNullBackend(&counts));
+  if (!mixer) {
+    fprintf(stderr, "Error starting the mixer\n");
+    return 1;
+  }
+  uint64_t start = ProfilerNow();
+  for (int i = 0; i < BURST_TRIGGERS; i++)
+    AudioPost(mixer, i % SIM_EVENT_COUNT, 1);
+  uint64_t postNs = ProfilerNow() - start;
+  AudioStats stats;
+  AudioMixerClose(mixer, &stats);
+  printf("burst of %d triggers:\n", BURST_TRIGGERS);
+  printf("  post:           %.1f ns/trigger\n",
+         (double)postNs / BURST_TRIGGERS);
+  printf("  queue full:     %lld (%.1f%%)\n", stats.queueDrops,
+         100.0 * stats.queueDrops / BURST_TRIGGERS);
+  printf("  dispatched:     %lld plays, %lld coalesced, %lld without a voice\n",
+         stats.played, stats.coalesced, stats.voiceDrops);
+
+  FILE *log = NULL;
+  if (logPath) {
+    log = fopen(logPath, "w");
+    if (!log) {
+      fprintf(stderr, "Error opening %s\n", logPath);
+      return 1;
+    }
+  }
+  bool ok = RunGame(seconds, swarm, AUDIO_GAME_VOICES, log, false) &&
+            RunGame(seconds, swarm, CONTENDED_VOICES, log, swarm > 0);
+  if (log)
+    fclose(log);
+  return ok ? 0 : 1;
+}
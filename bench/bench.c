@@ -0,0 +1,573 @@
+#include "broadphase.h"
+#include "highscore.h"
+#include "obstacles.h"
+#include "profiler.h"
+#include "render.h"
+#include "scene.h"
+#include "sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Microbenchmarks for the simulation's hot paths. Every benchmark is warmed
+// up, calibrated to run for at least --min-time per sample, warmed up again,
+// then sampled --reps times; the median and the median absolute deviation
+// of the per-operation time are reported. With --baseline the medians are
+// compared against a previous --json run and any regression fails the run.
+//
+// usage: raylibLearn_bench [--filter text] [--reps n] [--warmup n]
+//                          [--min-time ms] [--json file]
+//                          [--baseline file] [--threshold percent]
+
+#define MAX_SAMPLES 101
+#define CALIBRATION_RUNS 3
+#define MAX_BASELINE 64
+#define BENCH_HIGHSCORE_FILE "raylibLearn_bench_highscore.dat"
+
+typedef struct {
+  const char *name;
+  int param;
+  // Returns the benchmark's context, NULL on failure
+  void *(*setup)(int param);
+  // Runs iterations operations. The result is summed so the work can't be
+  // optimised away.
+  uint64_t (*run)(void *ctx, long long iterations);
+  void (*teardown)(void *ctx);
+} Benchmark;
+
+typedef struct {
+  char name[64];
+  double medianNs; // per operation
+  double madNs;
+  long long iterations; // per sample
+  int samples;
+} BenchResult;
+
+static volatile uint64_t sink;
+
+// Simulation benchmarks
+
+static void *SetupClassic(int param) {
+  (void)param;
+  GameState *state = malloc(sizeof(GameState));
+  if (state && !SimInit(state, 800, 600, 1)) {
+    free(state);
+    return NULL;
+  }
+  return state;
+}
+
+static void *SetupSwarm(int param) {
+  GameState *state = malloc(sizeof(GameState));
+  if (state && !SimInitSwarm(state, 800, 600, 1, param)) {
+    free(state);
+    return NULL;
+  }
+  return state;
+}
+
+static void TeardownState(void *ctx) {
+  SimFree(ctx);
+  free(ctx);
+}
+
+// The obstacle phase of SimStep(): integrate, respawn whatever fell off the
+// bottom, update the grid and test the player against it. One operation is
+// one tick over the whole field.
+static uint64_t RunObstacles(void *ctx, long long iterations) {
+  GameState *state = ctx;
+  ObstacleStore *obstacles = &state->obstacles;
+  const SimRect *player = &state->player.rect;
+  uint64_t hits = 0;
+  for (long long n = 0; n < iterations; n++) {
+    ObstaclesIntegrate(obstacles, 1.0f);
+    int fallen = ObstaclesFindBelow(obstacles, state->screenHeight);
+    for (int k = 0; k < fallen; k++) {
+      int i = obstacles->scratch[k];
+      obstacles->y[i] = -obstacles->h[i];
+    }
+    BroadphaseSetMany(&state->obstacleGrid, 0, obstacles->count, obstacles->x,
+                      obstacles->y, obstacles->w, obstacles->h);
+    int32_t blocker;
+    hits += (uint64_t)BroadphaseQuery(&state->obstacleGrid, player->x,
+                                      player->y, player->width,
+                                      player->height, &blocker, 1);
+  }
+  return hits;
+}
+
+#define SPAWN_BATCH 4096
+
+static void *SetupSpawnObstacles(int param) {
+  GameState *state = SetupClassic(param);
+  if (state && !ObstacleStoreReserve(&state->obstacles, SPAWN_BATCH)) {
+    TeardownState(state);
+    return NULL;
+  }
+  if (state)
+    state->maxObstacles = SPAWN_BATCH;
+  return state;
+}
+
+// Spawns into a field that empties every SPAWN_BATCH obstacles
+static uint64_t RunSpawnObstacles(void *ctx, long long iterations) {
+  GameState *state = ctx;
+  uint64_t total = 0;
+  for (long long n = 0; n < iterations; n++) {
+    int i = SimSpawnObstacle(state);
+    if (i < 0) {
+      state->obstacles.count = 0;
+      i = SimSpawnObstacle(state);
+    }
+    total += (uint64_t)i;
+  }
+  return total;
+}
+
+static void *SetupSpawnPowerUps(int param) {
+  GameState *state = SetupClassic(param);
+  if (state) {
+    for (int i = 0; i < MAX_POWERUPS - 1; i++)
+      SimSpawnPowerUp(state);
+  }
+  return state;
+}
+
+// Worst case free-slot scan: only the last slot is ever free
+static uint64_t RunSpawnPowerUps(void *ctx, long long iterations) {
+  GameState *state = ctx;
+  uint64_t total = 0;
+  for (long long n = 0; n < iterations; n++) {
+    int i = SimSpawnPowerUp(state);
+    total += (uint64_t)i;
+    state->powerUps[i].active = false;
+    BroadphaseRemove(&state->powerUpGrid, i);
+  }
+  return total;
+}
+
+// A steady field of param floor hit rings: every tick about 5% run out and
+// are emitted again
+static void *SetupParticles(int param) {
+  GameState *state = SetupClassic(param);
+  if (!state)
+    return NULL;
+  ParticleStore *particles = &state->particles;
+  // The whole field up front, no sample pays for growth
+  if (!ParticleStoreReserve(particles, param)) {
+    TeardownState(state);
+    return NULL;
+  }
+  for (int i = 0; i < param; i++)
+    SimEmitParticles(state, SIM_EFFECT_FLOOR_HIT, i % 800, 600, i % 5);
+  for (int i = 0; i < particles->count; i++)
+    particles->alpha[i] = (i % 20 + 1) * 0.05f;
+  return state;
+}
+
+static uint64_t RunParticles(void *ctx, long long iterations) {
+  GameState *state = ctx;
+  uint64_t total = 0;
+  int target = state->particles.count;
+  for (long long n = 0; n < iterations; n++) {
+    SimUpdateParticles(state, SIM_DT);
+    total += (uint64_t)(target - state->particles.count);
+    while (state->particles.count < target)
+      SimEmitParticles(state, SIM_EFFECT_FLOOR_HIT, (float)(n % 800), 600, 0);
+  }
+  return total;
+}
+
+#define EMIT_BURST_CAPACITY 256
+
+static void *SetupEmitBurst(int param) {
+  GameState *state = SetupClassic(param);
+  if (state && !ParticleStoreReserve(&state->particles, EMIT_BURST_CAPACITY)) {
+    TeardownState(state);
+    return NULL;
+  }
+  return state;
+}
+
+// One collision burst into an empty store. Emptying it every time keeps
+// the bursts in the same reserved, already touched slots, so an operation
+// is the emission alone rather than store growth and page faults.
+static uint64_t RunEmitBurst(void *ctx, long long iterations) {
+  GameState *state = ctx;
+  uint64_t total = 0;
+  for (long long n = 0; n < iterations; n++) {
+    state->particles.count = 0;
+    total += (uint64_t)SimEmitParticles(state, SIM_EFFECT_COLLISION, 400, 300,
+                                        SIM_COLOR_PLAYER);
+  }
+  return total;
+}
+
+// Whole SimStep() with the headless tool's sweeping input
+static uint64_t RunTick(void *ctx, long long iterations) {
+  GameState *state = ctx;
+  for (long long n = 0; n < iterations; n++) {
+    SimInput input =
+        ((state->tick / 90) & 1) ? SIM_INPUT_LEFT : SIM_INPUT_RIGHT;
+    if (state->gameOver)
+      input |= SIM_INPUT_RESTART;
+    SimStep(state, input, SIM_DT);
+  }
+  return state->tick;
+}
+
+// Render benchmarks
+
+typedef struct {
+  GameState state;
+  RenderList list;
+  SceneHud hud;
+  RenderNullCounts counts;
+} RenderBench;
+
+// A swarm field a few seconds in, so there are effects on screen too
+static void *SetupRender(int param) {
+  RenderBench *bench = calloc(1, sizeof(RenderBench));
+  if (!bench)
+    return NULL;
+  if (!SimInitSwarm(&bench->state, 800, 600, 1, param)) {
+    free(bench);
+    return NULL;
+  }
+  if (!RenderListInit(&bench->list)) {
+    SimFree(&bench->state);
+    free(bench);
+    return NULL;
+  }
+  RunTick(&bench->state, 300);
+  return bench;
+}
+
+static void TeardownRender(void *ctx) {
+  RenderBench *bench = ctx;
+  RenderListFree(&bench->list);
+  SimFree(&bench->state);
+  free(bench);
+}
+
+// Records the scene of one frame and flushes it to the null backend
+static uint64_t RunRenderFrame(void *ctx, long long iterations) {
+  RenderBench *bench = ctx;
+  RenderBackend backend = RenderNullBackend(&bench->counts);
+  uint64_t total = 0;
+  for (long long n = 0; n < iterations; n++) {
+    RenderBegin(&bench->list, RENDER_RAYWHITE);
+    SceneRecord(&bench->list, &bench->hud, &bench->state,
+                bench->state.score, (RenderImage){1, 64, 64});
+    total += (uint64_t)RenderFlush(&bench->list, &backend).batches;
+  }
+  return total;
+}
+
+// High score benchmarks
+
+static void *SetupHighScore(int param) {
+  (void)param;
+  remove(BENCH_HIGHSCORE_FILE);
+  return HighScoreOpen(BENCH_HIGHSCORE_FILE, 1e9f);
+}
+
+static void TeardownHighScore(void *ctx) {
+  HighScoreClose(ctx);
+  remove(BENCH_HIGHSCORE_FILE);
+}
+
+// The per-frame call, should never wait on the writer thread
+static uint64_t RunHighScoreSubmit(void *ctx, long long iterations) {
+  for (long long n = 0; n < iterations; n++)
+    HighScoreSubmit(ctx, (int)n);
+  return (uint64_t)HighScoreBest(ctx);
+}
+
+static void *SetupHighScoreFile(int param) {
+  (void)param;
+  // Start from a full leaderboard so every load parses one
+  HighScoreStore *store = SetupHighScore(param);
+  if (!store)
+    return NULL;
+  for (int i = 0; i < LEADERBOARD_SIZE; i++)
+    HighScoreRecordGame(store, 1000 + i);
+  HighScoreClose(store);
+  return (void *)BENCH_HIGHSCORE_FILE;
+}
+
+static void TeardownHighScoreFile(void *ctx) { remove(ctx); }
+
+// Load, record one game and save (the close waits for the write and fsync)
+static uint64_t RunHighScoreLoadSave(void *ctx, long long iterations) {
+  uint64_t total = 0;
+  for (long long n = 0; n < iterations; n++) {
+    HighScoreStore *store = HighScoreOpen(ctx, 1e9f);
+    if (!store)
+      continue;
+    HighScoreRecordGame(store, (int)(n % 2000));
+    total += (uint64_t)HighScoreBest(store);
+    HighScoreClose(store);
+  }
+  return total;
+}
+
+static const Benchmark benchmarks[] = {
+    {"obstacles", 20, SetupSwarm, RunObstacles, TeardownState},
+    {"obstacles", 1000, SetupSwarm, RunObstacles, TeardownState},
+    {"obstacles", 10000, SetupSwarm, RunObstacles, TeardownState},
+    {"obstacles", 100000, SetupSwarm, RunObstacles, TeardownState},
+    {"spawn_obstacle", 0, SetupSpawnObstacles, RunSpawnObstacles,
+     TeardownState},
+    {"spawn_powerup", 0, SetupSpawnPowerUps, RunSpawnPowerUps, TeardownState},
+    {"particles", 1000, SetupParticles, RunParticles, TeardownState},
+    {"particles", 100000, SetupParticles, RunParticles, TeardownState},
+    {"emit_collision", 0, SetupEmitBurst, RunEmitBurst, TeardownState},
+    {"highscore_submit", 0, SetupHighScore, RunHighScoreSubmit,
+     TeardownHighScore},
+    {"highscore_load_save", 0, SetupHighScoreFile, RunHighScoreLoadSave,
+     TeardownHighScoreFile},
+    {"tick_classic", 0, SetupClassic, RunTick, TeardownState},
+    {"tick_swarm", SIM_SWARM_OBSTACLES, SetupSwarm, RunTick, TeardownState},
+    {"render_frame", SIM_SWARM_OBSTACLES, SetupRender, RunRenderFrame,
+     TeardownRender},
+};
+
+#define BENCHMARK_COUNT (int)(sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+// Statistics
+
+static int CompareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Sorts values in place
+static double Median(double *values, int count) {
+  qsort(values, (size_t)count, sizeof(double), CompareDoubles);
+  return count % 2 ? values[count / 2]
+                   : 0.5 * (values[count / 2 - 1] + values[count / 2]);
+}
+
+static uint64_t TimeRun(const Benchmark *bench, void *ctx,
+                        long long iterations) {
+  uint64_t start = ProfilerNow();
+  sink += bench->run(ctx, iterations);
+  return ProfilerNow() - start;
+}
+
+static bool Measure(const Benchmark *bench, int warmup, int reps,
+                    double minTimeNs, BenchResult *result) {
+  void *ctx = bench->setup(bench->param);
+  if (!ctx)
+    return false;
+
+  // Run for a sample's time before calibrating, so first touches, page
+  // faults and cold caches don't make the batch look slower than it is
+  long long iterations = 1;
+  uint64_t warmed = 0;
+  while (warmed < minTimeNs && iterations < (1ll << 40)) {
+    warmed += TimeRun(bench, ctx, iterations);
+    iterations *= 2;
+  }
+
+  // Grow the batch until the median of a few samples takes at least
+  // minTimeNs, one slow run can't end it early
+  iterations = 1;
+  for (;;) {
+    double runs[CALIBRATION_RUNS];
+    for (int i = 0; i < CALIBRATION_RUNS; i++)
+      runs[i] = (double)TimeRun(bench, ctx, iterations);
+    double elapsed = Median(runs, CALIBRATION_RUNS);
+    if (elapsed >= minTimeNs || iterations >= (1ll << 40))
+      break;
+    double scale = elapsed > 0 ? 1.2 * minTimeNs / elapsed : 10.0;
+    iterations = (long long)(iterations * (scale < 10.0 ? scale : 10.0)) + 1;
+  }
+  for (int i = 0; i < warmup; i++)
+    TimeRun(bench, ctx, iterations);
+
+  double samples[MAX_SAMPLES];
+  for (int i = 0; i < reps; i++)
+    samples[i] = (double)TimeRun(bench, ctx, iterations) / iterations;
+  bench->teardown(ctx);
+
+  double median = Median(samples, reps);
+  for (int i = 0; i < reps; i++)
+    samples[i] = fabs(samples[i] - median);
+  result->medianNs = median;
+  result->madNs = Median(samples, reps);
+  result->iterations = iterations;
+  result->samples = reps;
+  return true;
+}
+
+// JSON in and out. The reader only understands what WriteJson() produces.
+
+static bool WriteJson(const char *path, const BenchResult *results, int count) {
+  FILE *file = fopen(path, "w");
+  if (!file)
+    return false;
+  fprintf(file, "{\n  \"benchmarks\": [\n");
+  for (int i = 0; i < count; i++) {
+    const BenchResult *r = &results[i];
+    fprintf(file,
+            "    {\"name\": \"%s\", \"median_ns\": %.3f, \"mad_ns\": %.3f, "
+            "\"iterations\": %lld, \"samples\": %d}%s\n",
+            r->name, r->medianNs, r->madNs, r->iterations, r->samples,
+            i + 1 < count ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  return fclose(file) == 0;
+}
+
+static int ReadBaseline(const char *path, BenchResult *out, int max) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return -1;
+  static char text[1 << 16];
+  size_t size = fread(text, 1, sizeof(text) - 1, file);
+  fclose(file);
+  text[size] = '\0';
+
+  int count = 0;
+  const char *p = text;
+  while (count < max && (p = strstr(p, "\"name\": \""))) {
+    p += strlen("\"name\": \"");
+    const char *end = strchr(p, '"');
+    const char *median = strstr(p, "\"median_ns\": ");
+    if (!end || !median)
+      break;
+    BenchResult *r = &out[count++];
+    memset(r, 0, sizeof(*r));
+    size_t length = (size_t)(end - p);
+    if (length >= sizeof(r->name))
+      length = sizeof(r->name) - 1;
+    memcpy(r->name, p, length);
+    r->medianNs = strtod(median + strlen("\"median_ns\": "), NULL);
+    p = end;
+  }
+  return count;
+}
+
+static const BenchResult *FindResult(const BenchResult *results, int count,
+                                     const char *name) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(results[i].name, name) == 0)
+      return &results[i];
+  }
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  const char *filter = NULL;
+  const char *jsonPath = NULL;
+  const char *baselinePath = NULL;
+  int reps = 15;
+  int warmup = 3;
+  double minTimeMs = 10.0;
+  double threshold = 15.0; // percent
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--filter") == 0 && hasValue)
+      filter = argv[++i];
+    else if (strcmp(argv[i], "--reps") == 0 && hasValue)
+      reps = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+      warmup = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--min-time") == 0 && hasValue)
+      minTimeMs = atof(argv[++i]);
+    else if (strcmp(argv[i], "--json") == 0 && hasValue)
+      jsonPath = argv[++i];
+    else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+      baselinePath = argv[++i];
+    else if (strcmp(argv[i], "--threshold") == 0 && hasValue)
+      threshold = atof(argv[++i]);
+    else {
+      fprintf(stderr,
+              "usage: %s [--filter text] [--reps n] [--warmup n] "
+              "[--min-time ms] [--json file] [--baseline file] "
+              "[--threshold percent]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (reps < 1 || reps > MAX_SAMPLES || warmup < 0 || minTimeMs <= 0) {
+    fprintf(stderr, "--reps must be 1..%d, --warmup >= 0, --min-time > 0\n",
+            MAX_SAMPLES);
+    return 1;
+  }
+
+  BenchResult baseline[MAX_BASELINE];
+  int baselineCount = 0;
+  if (baselinePath) {
+    baselineCount = ReadBaseline(baselinePath, baseline, MAX_BASELINE);
+    if (baselineCount < 0) {
+      fprintf(stderr, "Error reading baseline %s\n", baselinePath);
+      return 1;
+    }
+  }
+
+  // Only the benchmarks should show up if a profiler build is timing zones
+  PROFILE_SUSPEND();
+
+  printf("obstacle kernels: %s\n", ObstacleKernelName());
+  printf("%-28s %14s %10s %12s", "benchmark", "median ns/op", "MAD", "iters");
+  if (baselinePath)
+    printf(" %12s %8s", "baseline", "change");
+  printf("\n");
+
+  BenchResult results[BENCHMARK_COUNT];
+  int count = 0;
+  int regressions = 0;
+  for (int i = 0; i < BENCHMARK_COUNT; i++) {
+    const Benchmark *bench = &benchmarks[i];
+    BenchResult *result = &results[count];
+    memset(result, 0, sizeof(*result));
+    if (bench->param > 0)
+      snprintf(result->name, sizeof(result->name), "%s/%d", bench->name,
+               bench->param);
+    else
+      snprintf(result->name, sizeof(result->name), "%s", bench->name);
+    if (filter && !strstr(result->name, filter))
+      continue;
+
+    if (!Measure(bench, warmup, reps, minTimeMs * 1e6, result)) {
+      fprintf(stderr, "%s: setup failed\n", result->name);
+      return 1;
+    }
+    count++;
+    printf("%-28s %14.1f %10.1f %12lld", result->name, result->medianNs,
+           result->madNs, result->iterations);
+
+    const BenchResult *base =
+        baselinePath ? FindResult(baseline, baselineCount, result->name)
+                     : NULL;
+    if (base && base->medianNs > 0) {
+      double change = 100.0 * (result->medianNs / base->medianNs - 1.0);
+      // Slower by more than the threshold, and by more than the noise
+      bool regressed =
+          change > threshold &&
+          result->medianNs - base->medianNs > 3.0 * result->madNs;
+      printf(" %12.1f %+7.1f%%%s", base->medianNs, change,
+             regressed ? "  REGRESSION" : "");
+      regressions += regressed;
+    } else if (baselinePath) {
+      printf(" %12s", "new");
+    }
+    printf("\n");
+  }
+  PROFILE_RESUME();
+
+  if (jsonPath && !WriteJson(jsonPath, results, count)) {
+    fprintf(stderr, "Error writing %s\n", jsonPath);
+    return 1;
+  }
+  if (regressions > 0) {
+    printf("%d regression(s) over %.1f%%\n", regressions, threshold);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,175 @@
+#include "broadphase.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Checks the spatial hash against brute force, then compares query cost as
+// the entity count grows (at constant density). Exits non-zero if any
+// query or pair list differs from the brute-force answer.
+//
+// usage: raylibLearn_broadphase_bench [max entities]
+
+#define QUERIES 2000
+#define PAIR_CHECK_LIMIT 10000 // brute-force pairs are O(n^2)
+
+static double Now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static float RandomRange(float min, float max) {
+  return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+static bool Overlaps(float ax, float ay, float aw, float ah, float bx,
+                     float by, float bw, float bh) {
+  return ax < bx + bw && ax + aw > bx && ay < by + bh && ay + ah > by;
+}
+
+static int CompareInt(const void *a, const void *b) {
+  return *(const int32_t *)a - *(const int32_t *)b;
+}
+
+static int ComparePair(const void *a, const void *b) {
+  const BroadphasePair *pa = a, *pb = b;
+  return pa->a != pb->a ? pa->a - pb->a : pa->b - pb->b;
+}
+
+typedef struct {
+  float *x, *y, *w, *h;
+  int n;
+} Boxes;
+
+static int BruteQuery(const Boxes *boxes, float x, float y, float w, float h,
+                      int32_t *out) {
+  int found = 0;
+  for (int i = 0; i < boxes->n; i++) {
+    if (Overlaps(x, y, w, h, boxes->x[i], boxes->y[i], boxes->w[i],
+                 boxes->h[i]))
+      out[found++] = i;
+  }
+  return found;
+}
+
+static bool VerifyQueries(const Broadphase *bp, const Boxes *boxes,
+                          float worldSize, int32_t *a, int32_t *b) {
+  for (int q = 0; q < QUERIES; q++) {
+    float x = RandomRange(-50, worldSize);
+    float y = RandomRange(-50, worldSize);
+    float w = RandomRange(1, 120);
+    float h = RandomRange(1, 120);
+    int na = BroadphaseQuery(bp, x, y, w, h, a, boxes->n);
+    int nb = BruteQuery(boxes, x, y, w, h, b);
+    qsort(a, na, sizeof(int32_t), CompareInt);
+    if (na != nb || memcmp(a, b, na * sizeof(int32_t)) != 0) {
+      fprintf(stderr, "query mismatch: %d vs %d results\n", na, nb);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool VerifyPairs(const Broadphase *bp, const Boxes *boxes) {
+  int max = boxes->n * 16;
+  BroadphasePair *grid = malloc(max * sizeof(BroadphasePair));
+  BroadphasePair *brute = malloc(max * sizeof(BroadphasePair));
+  int nb = 0;
+  for (int i = 0; i < boxes->n && nb < max; i++) {
+    for (int j = i + 1; j < boxes->n && nb < max; j++) {
+      if (Overlaps(boxes->x[i], boxes->y[i], boxes->w[i], boxes->h[i],
+                   boxes->x[j], boxes->y[j], boxes->w[j], boxes->h[j]))
+        brute[nb++] = (BroadphasePair){i, j};
+    }
+  }
+  int ng = BroadphasePairs(bp, grid, max);
+  qsort(grid, ng, sizeof(BroadphasePair), ComparePair);
+  bool ok = ng == nb && memcmp(grid, brute, ng * sizeof(BroadphasePair)) == 0;
+  if (!ok)
+    fprintf(stderr, "pair mismatch: %d vs %d pairs\n", ng, nb);
+  free(grid);
+  free(brute);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  int maxCount = argc > 1 ? atoi(argv[1]) : 100000;
+  srand(1);
+
+  printf("%10s %12s %12s %12s %10s\n", "entities", "grid ns/q", "brute ns/q",
+         "update ns/e", "pairs");
+  for (int n = 100; n <= maxCount; n *= 10) {
+    // Constant density: about one 30px box per 40x40 area
+    float worldSize = 40.0f * sqrtf((float)n);
+    Boxes boxes = {malloc(n * sizeof(float)), malloc(n * sizeof(float)),
+                   malloc(n * sizeof(float)), malloc(n * sizeof(float)), n};
+    int32_t *a = malloc(n * sizeof(int32_t));
+    int32_t *b = malloc(n * sizeof(int32_t));
+    Broadphase bp;
+    if (!BroadphaseInit(&bp, 64.0f, n)) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+    for (int i = 0; i < n; i++) {
+      boxes.x[i] = RandomRange(0, worldSize);
+      boxes.y[i] = RandomRange(0, worldSize);
+      boxes.w[i] = RandomRange(4, 30);
+      boxes.h[i] = RandomRange(4, 30);
+    }
+    BroadphaseSetMany(&bp, 0, n, boxes.x, boxes.y, boxes.w, boxes.h);
+    if (!VerifyQueries(&bp, &boxes, worldSize, a, b))
+      return 1;
+
+    // Incremental moves, like falling obstacles
+    double start = Now();
+    for (int step = 0; step < 10; step++) {
+      for (int i = 0; i < n; i++)
+        boxes.y[i] += 5.0f;
+      BroadphaseSetMany(&bp, 0, n, boxes.x, boxes.y, boxes.w, boxes.h);
+    }
+    double update = (Now() - start) / (10.0 * n) * 1e9;
+    if (!VerifyQueries(&bp, &boxes, worldSize, a, b))
+      return 1;
+
+    // Remove a few and check again
+    for (int i = n - 1; i >= n - n / 10; i--)
+      BroadphaseRemove(&bp, i);
+    boxes.n = n - n / 10;
+    if (!VerifyQueries(&bp, &boxes, worldSize, a, b))
+      return 1;
+    const char *pairs = "skipped";
+    if (boxes.n <= PAIR_CHECK_LIMIT) {
+      if (!VerifyPairs(&bp, &boxes))
+        return 1;
+      pairs = "ok";
+    }
+
+    // Player-sized queries
+    volatile int sink = 0;
+    start = Now();
+    for (int q = 0; q < QUERIES; q++)
+      sink += BroadphaseQuery(&bp, RandomRange(0, worldSize),
+                              RandomRange(0, worldSize), 30, 30, a, boxes.n);
+    double gridNs = (Now() - start) / QUERIES * 1e9;
+    start = Now();
+    for (int q = 0; q < QUERIES; q++)
+      sink += BruteQuery(&boxes, RandomRange(0, worldSize),
+                         RandomRange(0, worldSize), 30, 30, b);
+    double bruteNs = (Now() - start) / QUERIES * 1e9;
+
+    printf("%10d %12.0f %12.0f %12.1f %10s\n", n, gridNs, bruteNs, update,
+           pairs);
+
+    BroadphaseFree(&bp);
+    free(boxes.x);
+    free(boxes.y);
+    free(boxes.w);
+    free(boxes.h);
+    free(a);
+    free(b);
+  }
+  printf("all results match brute force\n");
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include "obstacles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Obstacle update throughput: the original array-of-structs loop against the
+// SoA store with scalar and SIMD kernels.
+//
+// usage: raylibLearn_obstacles_bench [max obstacles]
+
+#define SCREEN_HEIGHT 600.0f
+#define WORK_PER_RUN 50000000.0 // obstacle updates per measurement
+
+// The pre-SoA layout and loop, kept here as the baseline
+typedef struct {
+  struct {
+    float x, y, width, height;
+  } rect;
+  struct {
+    float x, y;
+  } speed;
+  unsigned char color[4];
+  bool active;
+} AosObstacle;
+
+static double Now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool CheckCollision(float ax, float ay, float aw, float ah, float bx,
+                           float by, float bw, float bh) {
+  return ax < bx + bw && ax + aw > bx && ay < by + bh && ay + ah > by;
+}
+
+// The player sits off screen so every tick tests every obstacle
+static const float playerX = -1000.0f, playerY = 480.0f, playerSize = 30.0f;
+
+static int AosTick(AosObstacle *obstacles, int capacity) {
+  int hits = 0;
+  for (int i = 0; i < capacity; i++) {
+    if (obstacles[i].active) {
+      obstacles[i].rect.y += obstacles[i].speed.y;
+      if (obstacles[i].rect.y > SCREEN_HEIGHT)
+        obstacles[i].rect.y = -obstacles[i].rect.height;
+      if (CheckCollision(playerX, playerY, playerSize, playerSize,
+                         obstacles[i].rect.x, obstacles[i].rect.y,
+                         obstacles[i].rect.width, obstacles[i].rect.height))
+        hits++;
+    }
+  }
+  return hits;
+}
+
+static int SoaTickScalar(ObstacleStore *store) {
+  ObstaclesIntegrateScalar(store, 1.0f);
+  int fallen = ObstaclesFindBelowScalar(store, SCREEN_HEIGHT);
+  for (int k = 0; k < fallen; k++) {
+    int i = store->scratch[k];
+    store->y[i] = -store->h[i];
+  }
+  return ObstaclesFirstOverlapScalar(store, playerX, playerY, playerSize,
+                                     playerSize) >= 0;
+}
+
+static int SoaTickSimd(ObstacleStore *store) {
+  ObstaclesIntegrate(store, 1.0f);
+  int fallen = ObstaclesFindBelow(store, SCREEN_HEIGHT);
+  for (int k = 0; k < fallen; k++) {
+    int i = store->scratch[k];
+    store->y[i] = -store->h[i];
+  }
+  return ObstaclesFirstOverlap(store, playerX, playerY, playerSize,
+                               playerSize) >= 0;
+}
+
+int main(int argc, char **argv) {
+  int maxCount = argc > 1 ? atoi(argv[1]) : 1000000;
+
+  printf("kernels: %s\n", ObstacleKernelName());
+  printf("%10s %14s %14s %14s %8s\n", "obstacles", "aos Mupd/s",
+         "soa-scalar", "soa-simd", "speedup");
+
+  static const int sizes[] = {20, 1000, 10000, 100000, 1000000};
+  for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+    int count = sizes[s];
+    if (count > maxCount)
+      break;
+    // The AoS pool keeps the old layout: the tail is inactive slots
+    int capacity = count + count / 4;
+    AosObstacle *aos = calloc(capacity, sizeof(AosObstacle));
+    ObstacleStore store;
+    if (!aos || !ObstacleStoreInit(&store, count)) {
+      fprintf(stderr, "out of memory at %d obstacles\n", count);
+      return 1;
+    }
+    srand(1);
+    for (int i = 0; i < count; i++) {
+      float x = rand() % 800;
+      float y = rand() % 600;
+      float speed = 3.0f + (rand() % 200) / 100.0f;
+      aos[i] = (AosObstacle){{x, y, 30, 30}, {0, speed}, {0}, true};
+      ObstacleStorePush(&store, x, y, 30, 30, speed, 0);
+    }
+
+    int ticks = (int)(WORK_PER_RUN / count);
+    if (ticks < 10)
+      ticks = 10;
+    volatile int sink = 0;
+    double rates[3];
+    for (int variant = 0; variant < 3; variant++) {
+      double start = Now();
+      for (int t = 0; t < ticks; t++) {
+        if (variant == 0)
+          sink += AosTick(aos, capacity);
+        else if (variant == 1)
+          sink += SoaTickScalar(&store);
+        else
+          sink += SoaTickSimd(&store);
+      }
+      double elapsed = Now() - start;
+      rates[variant] = (double)count * ticks / elapsed / 1e6;
+    }
+    printf("%10d %14.1f %14.1f %14.1f %7.1fx\n", count, rates[0], rates[1],
+           rates[2], rates[2] / rates[0]);
+
+    ObstacleStoreFree(&store);
+    free(aos);
+  }
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include "particles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Particle update throughput in particles per millisecond: the old
+// fixed-pool effect loop (active flags, linear scan for a free slot) against
+// the SoA store with scalar and SIMD kernels. About 1% of the particles
+// expire and are re-emitted every tick.
+//
+// usage: raylibLearn_particles_bench [max particles]
+
+#define WORK_PER_RUN 50000000.0 // particle updates per measurement
+// The pool's free-slot scan is quadratic, it is skipped past this size
+#define MAX_POOL_COUNT 10000
+
+// The pre-SoA layout and loops, kept here as the baseline
+typedef struct {
+  struct {
+    float x, y;
+  } position;
+  struct {
+    float x, y;
+  } velocity;
+  float radius;
+  float alpha;
+  unsigned char color;
+  bool active;
+} PoolEffect;
+
+static double Now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Alphas are staggered so that a steady 1% runs out every tick
+static Particle MakeParticle(int i) {
+  return (Particle){.x = (float)(i % 800),
+                    .y = 600.0f,
+                    .vx = (i % 7) - 3.0f,
+                    .vy = -2.0f,
+                    .radius = 10.0f,
+                    .growth = 0.05f,
+                    .alpha = (i % 100 + 1) * 0.01f,
+                    .fade = 0.01f,
+                    .color = (unsigned char)(i % 5)};
+}
+
+static int PoolTick(PoolEffect *pool, int capacity) {
+  int expired = 0;
+  for (int i = 0; i < capacity; i++) {
+    PoolEffect *effect = &pool[i];
+    if (effect->active) {
+      effect->position.x += effect->velocity.x;
+      effect->position.y += effect->velocity.y;
+      effect->radius += 0.05f;
+      effect->alpha -= 0.01f;
+      if (effect->alpha <= 0.0f) {
+        effect->active = false;
+        expired++;
+      }
+    }
+  }
+  // Re-emit, each one scanning for a free slot
+  for (int k = 0; k < expired; k++) {
+    for (int i = 0; i < capacity; i++) {
+      if (!pool[i].active) {
+        Particle p = MakeParticle(i);
+        pool[i] = (PoolEffect){{p.x, p.y}, {p.vx, p.vy}, p.radius, 1.0f,
+                               p.color, true};
+        break;
+      }
+    }
+  }
+  return expired;
+}
+
+static int StoreTick(ParticleStore *store, bool simd) {
+  if (simd)
+    ParticlesIntegrate(store, 1.0f);
+  else
+    ParticlesIntegrateScalar(store, 1.0f);
+  int expired = simd ? ParticlesExpire(store) : ParticlesExpireScalar(store);
+  for (int k = 0; k < expired; k++) {
+    Particle p = MakeParticle(store->count);
+    p.alpha = 1.0f;
+    ParticleStorePush(store, &p);
+  }
+  return expired;
+}
+
+int main(int argc, char **argv) {
+  int maxCount = argc > 1 ? atoi(argv[1]) : 1000000;
+
+  printf("%10s %14s %14s %14s %8s\n", "particles", "pool p/ms",
+         "soa-scalar", "soa-simd", "speedup");
+
+  static const int sizes[] = {20, 1000, 10000, 100000, 1000000};
+  for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+    int count = sizes[s];
+    if (count > maxCount)
+      break;
+    // The pool keeps the old layout: the tail is inactive slots
+    int capacity = count + count / 4;
+    PoolEffect *pool = calloc(capacity, sizeof(PoolEffect));
+    ParticleStore stores[2];
+    if (!pool || !ParticleStoreInit(&stores[0], count) ||
+        !ParticleStoreInit(&stores[1], count)) {
+      fprintf(stderr, "out of memory at %d particles\n", count);
+      return 1;
+    }
+    for (int i = 0; i < count; i++) {
+      Particle p = MakeParticle(i);
+      pool[i] = (PoolEffect){{p.x, p.y}, {p.vx, p.vy}, p.radius, p.alpha,
+                             p.color, true};
+      ParticleStorePush(&stores[0], &p);
+      ParticleStorePush(&stores[1], &p);
+    }
+
+    int ticks = (int)(WORK_PER_RUN / count);
+    if (ticks < 10)
+      ticks = 10;
+    volatile int sink = 0;
+    double rates[3] = {0};
+    for (int variant = 0; variant < 3; variant++) {
+      if (variant == 0 && count > MAX_POOL_COUNT)
+        continue;
+      double start = Now();
+      for (int t = 0; t < ticks; t++) {
+        if (variant == 0)
+          sink += PoolTick(pool, capacity);
+        else
+          sink += StoreTick(&stores[variant - 1], variant == 2);
+      }
+      double elapsed = Now() - start;
+      rates[variant] = (double)count * ticks / elapsed / 1e3;
+    }
+    if (rates[0] > 0)
+      printf("%10d %14.0f %14.0f %14.0f %7.1fx\n", count, rates[0], rates[1],
+             rates[2], rates[2] / rates[0]);
+    else
+      printf("%10d %14s %14.0f %14.0f %8s\n", count, "-", rates[1],
+             rates[2], "-");
+
+    ParticleStoreFree(&stores[0]);
+    ParticleStoreFree(&stores[1]);
+    free(pool);
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include "bot.h"
+#include "render.h"
+#include "scene.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Render list efficiency over reflex bot games, drawn with the null backend:
+// commands per frame, the batches they sort into against the batches
+// recording order would need, HUD strings formatted against the 5 per frame
+// before the cache, and the cost of recording and flushing a frame. Exits
+// non-zero if a flush ever hands batches out of layer and primitive order.
+//
+// usage: raylibLearn_render_bench [frames] [swarm obstacles] [seed]
+
+static double Now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Wraps the null backend and checks the batch order of each frame
+typedef struct {
+  RenderNullCounts counts;
+  RenderBackend null;
+  int lastKey;
+  long long misordered;
+} CheckedBackend;
+
+static void CheckedClear(void *context, RenderColor color) {
+  CheckedBackend *checked = context;
+  checked->lastKey = -1;
+  checked->null.clear(checked->null.context, color);
+}
+
+static void CheckedBatch(void *context, const RenderList *list,
+                         const RenderCommand *commands, int count) {
+  CheckedBackend *checked = context;
+  for (int i = 0; i < count; i++) {
+    int key = commands[i].layer * RENDER_PRIMITIVE_COUNT +
+              commands[i].primitive;
+    if (key < checked->lastKey)
+      checked->misordered++;
+    checked->lastKey = key;
+  }
+  checked->null.batch(checked->null.context, list, commands, count);
+}
+
+int main(int argc, char **argv) {
+  long long frames = argc > 1 ? atoll(argv[1]) : 100000;
+  int swarm = argc > 2 ? atoi(argv[2]) : SIM_SWARM_OBSTACLES;
+  uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+  if (frames < 1) {
+    fprintf(stderr, "frames must be positive\n");
+    return 1;
+  }
+
+  GameState game;
+  bool ready = swarm > 0 ? SimInitSwarm(&game, 800, 600, seed, swarm)
+                         : SimInit(&game, 800, 600, seed);
+  RenderList list;
+  if (!ready || !RenderListInit(&list)) {
+    fprintf(stderr, "Error allocating the game state\n");
+    return 1;
+  }
+  CheckedBackend checked = {0};
+  checked.null = RenderNullBackend(&checked.counts);
+  RenderBackend backend = {&checked, CheckedClear, CheckedBatch};
+  SceneHud hud = {0};
+  RenderImage star = {1, 64, 64};
+
+  long long batches = 0;
+  long long unsortedBatches = 0;
+  long long dropped = 0;
+  long long games = 1;
+  int best = 0;
+  double renderTime = 0.0;
+  for (long long f = 0; f < frames; f++) {
+    SimInput input = BotReflex(&game);
+    if (game.gameOver) {
+      input |= SIM_INPUT_RESTART;
+      games++;
+    }
+    SimStep(&game, input, SIM_DT);
+    if (game.score > best)
+      best = game.score;
+
+    double start = Now();
+    RenderBegin(&list, RENDER_RAYWHITE);
+    SceneRecord(&list, &hud, &game, best, star);
+    RenderStats stats = RenderFlush(&list, &backend);
+    renderTime += Now() - start;
+
+    batches += stats.batches;
+    unsortedBatches += stats.unsortedBatches;
+    dropped += stats.dropped;
+  }
+
+  const RenderNullCounts *counts = &checked.counts;
+  printf("frames:           %lld (%lld games)\n", frames, games);
+  printf("commands/frame:   %.1f\n", (double)counts->commands / frames);
+  printf("  rects:          %.1f\n",
+         (double)counts->primitives[RENDER_RECT] / frames);
+  printf("  circles:        %.1f\n",
+         (double)counts->primitives[RENDER_CIRCLE] / frames);
+  printf("  textures:       %.1f\n",
+         (double)counts->primitives[RENDER_TEXTURE] / frames);
+  printf("  text:           %.1f\n",
+         (double)counts->primitives[RENDER_TEXT] / frames);
+  printf("batches/frame:    %.2f sorted, %.2f in recording order\n",
+         (double)batches / frames, (double)unsortedBatches / frames);
+  printf("HUD formats:      %.3f/frame (uncached: 4-5/frame)\n",
+         (double)SceneHudRebuilds(&hud) / frames);
+  printf("record+flush:     %.2f us/frame\n", renderTime / frames * 1e6);
+  if (dropped)
+    printf("dropped:          %lld commands\n", dropped);
+
+  RenderListFree(&list);
+  SimFree(&game);
+  if (checked.misordered) {
+    fprintf(stderr, "%lld commands flushed out of order\n",
+            checked.misordered);
+    return 1;
+  }
+  return 0;
+}
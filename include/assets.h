@@ -0,0 +1,55 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// Asynchronous asset loading. A background thread maps the resource bundle
+// (decoding loose files for anything the bundle doesn't have) while the main
+// thread keeps drawing. Once the loader is ready the main thread makes the
+// sounds and textures, which only copies the decoded data to the audio
+// device and the GPU.
+
+#define RESOURCE_BUNDLE "resources.pack"
+#define RESOURCE_DIR "resources"
+#define MAX_ASSETS 32
+
+// The game's assets, in load order
+typedef enum {
+  ASSET_COLLISION_SOUND,
+  ASSET_POWERUP_SOUND,
+  ASSET_FLOOR_HIT_SOUND,
+  ASSET_STAR_TEXTURE,
+  ASSET_COUNT
+} GameAsset;
+
+extern const char *const gameAssetNames[ASSET_COUNT];
+
+typedef struct AssetLoader AssetLoader;
+
+// Starts loading the named files. bundlePath may be NULL to decode
+// everything from fallbackDir. Returns NULL if the thread can't start.
+AssetLoader *AssetsLoadAsync(const char *bundlePath, const char *fallbackDir,
+                             const char *const names[], int count);
+bool AssetsReady(AssetLoader *loader);
+// Fraction of the assets loaded so far
+float AssetsProgress(AssetLoader *loader);
+void AssetsWait(AssetLoader *loader);
+// After AssetsReady(): whether the bundle was used, and how long loading
+// took from AssetsLoadAsync()
+bool AssetsFromBundle(AssetLoader *loader);
+double AssetsLoadMs(AssetLoader *loader);
+
+// Decoded data, valid until AssetsClose(). Zeroed if the asset failed to
+// load or is of the other kind.
+Wave AssetsWave(AssetLoader *loader, int index);
+Image AssetsImage(AssetLoader *loader, int index);
+// Main thread only, they need the audio device and the GL context
+Sound AssetsSound(AssetLoader *loader, int index);
+Texture2D AssetsTexture(AssetLoader *loader, int index);
+
+// Waits for the thread and frees the decoded data (sounds and textures
+// made from it stay valid)
+void AssetsClose(AssetLoader *loader);
+
+#endif // ASSETS_H
@@ -0,0 +1,84 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include "sim.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Sound triggers go through a bounded queue to a dispatch thread instead of
+// straight to the audio device. Posting is a few atomic operations and never
+// blocks. The dispatch thread coalesces triggers of a sound that land within
+// its window of the last play into that play, and hands out voices: a sound
+// plays at most maxVoices times at once, all sounds share the mixer's voice
+// limit, and when every voice is busy a sound steals the voice of a lower
+// priority one. Plays go to a backend (raylib in the game, a null or file
+// backend headless).
+
+#define AUDIO_MAX_SOUNDS 8
+#define AUDIO_MAX_VOICES 16
+#define AUDIO_QUEUE_SIZE 1024 // power of two
+// How often the dispatch thread drains the queue
+#define AUDIO_DISPATCH_MS 2
+
+typedef struct {
+  int priority;     // higher steals voices from lower when all are busy
+  int maxVoices;    // plays of this sound at once, up to AUDIO_MAX_VOICES
+  float coalesceMs; // triggers this soon after a play merge into it
+  float durationMs; // how long a play holds its voice
+} AudioSoundConfig;
+
+// The game's sounds, indexed by SimEvent. Durations are placeholders until
+// the sounds are loaded. The voices are fewer than the per-sound limits add
+// up to, so a rarer sound can take one from a floor hit flood.
+#define AUDIO_GAME_VOICES 4
+extern const AudioSoundConfig audioGameSounds[SIM_EVENT_COUNT];
+
+// Called from the dispatch thread. voice is in [0, maxVoices) of the sound,
+// one play at a time per voice.
+typedef struct {
+  void *context;
+  void (*play)(void *context, int sound, int voice);
+  void (*stop)(void *context, int sound, int voice); // cut short, stolen
+} AudioBackend;
+
+// Counted in triggers: posted = queueDrops + coalesced + voiceDrops +
+// played once the queue is drained
+typedef struct {
+  long long posted;
+  long long queueDrops; // queue full
+  long long coalesced;  // merged into a play
+  long long voiceDrops; // no voice free for them
+  long long played;
+  long long stolen; // plays cut short for a higher priority sound
+  int activeVoices;
+  int peakVoices;
+} AudioStats;
+
+typedef struct AudioMixer AudioMixer;
+
+// Starts the dispatch thread. sounds[i] configures sound i, maxVoices is the
+// limit over all of them. Returns NULL on failure.
+AudioMixer *AudioMixerOpen(const AudioSoundConfig *sounds, int count,
+                           int maxVoices, AudioBackend backend);
+// Dispatches what is still queued, then stops the thread. stats, if not
+// NULL, gets the final counts.
+void AudioMixerClose(AudioMixer *mixer, AudioStats *stats);
+
+// count triggers of the sound at once (a tick's floor hits, say). One
+// posting thread. Returns false if the queue was full and they were dropped.
+bool AudioPost(AudioMixer *mixer, int sound, int count);
+// From the posting thread
+AudioStats AudioMixerStats(AudioMixer *mixer);
+
+// Counts plays and stops per sound, read them after AudioMixerClose()
+typedef struct {
+  long long plays[AUDIO_MAX_SOUNDS];
+  long long stops[AUDIO_MAX_SOUNDS];
+} AudioNullCounts;
+
+AudioBackend AudioNullBackend(AudioNullCounts *counts);
+// Writes "ms,play|stop,sound,voice" lines, ms from ProfilerNow()
+AudioBackend AudioFileBackend(FILE *file);
+
+#endif // AUDIO_H
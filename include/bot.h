@@ -0,0 +1,41 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "sim.h"
+
+// Scripted players for headless runs
+
+// Reacts to what is directly above: sidesteps the nearest falling obstacle
+// and otherwise drifts towards power-ups or the middle of the screen.
+// Deterministic, it only reads the state.
+SimInput BotReflex(const GameState *state);
+
+// Lookahead autopilot. Every decision snapshots the live state and runs
+// as many Monte Carlo rollouts as fit in the time budget: each rollout
+// holds one of the candidate moves, then plays random moves up to the
+// horizon, scoring survival time and pickups. The move with the best
+// average wins.
+
+#define AUTOPILOT_MOVES 9        // idle plus 8 directions
+#define AUTOPILOT_HOLD_TICKS 6   // ticks each random move is held
+#define AUTOPILOT_HORIZON 120    // ticks simulated per rollout
+
+typedef struct {
+  GameState scratch;
+  SimSnapshot root;
+  uint64_t rng;
+
+  // Last decision
+  int rollouts;
+  double rolloutsPerSecond;
+  double moveScore[AUTOPILOT_MOVES];
+  int moveRollouts[AUTOPILOT_MOVES];
+} Autopilot;
+
+bool AutopilotInit(Autopilot *pilot, uint64_t seed);
+void AutopilotFree(Autopilot *pilot);
+// Picks the input for the next ticks, spending about budgetMs
+SimInput AutopilotDecide(Autopilot *pilot, const GameState *state,
+                         double budgetMs);
+
+#endif // BOT_H
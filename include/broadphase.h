@@ -0,0 +1,66 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Spatial hash broadphase. Entities are axis-aligned boxes identified by a
+// dense integer handle (e.g. their index in an ObstacleStore). Each entity
+// is filed under the cell holding its top-left corner, so moving it is O(1)
+// and only relinks when it crosses a cell boundary. Queries widen their
+// cell range by the largest entity size seen, so boxes bigger than a cell
+// are still found, just less efficiently.
+//
+// Query results are exact overlaps (cells, then an AABB test), using the
+// same test as SimCheckCollision().
+
+typedef struct {
+  int32_t a;
+  int32_t b;
+} BroadphasePair;
+
+typedef struct {
+  float cellSize;
+  float invCellSize;
+  float maxWidth;
+  float maxHeight;
+
+  // Per handle
+  float *x;
+  float *y;
+  float *w;
+  float *h;
+  int32_t *cellX;
+  int32_t *cellY;
+  int32_t *next; // -1 terminated bucket chain
+  int32_t *prev; // -1 for the head of a chain
+  bool *present;
+  int capacity;
+  int count;
+
+  int32_t *buckets; // head handle per bucket, -1 if empty
+  uint32_t bucketMask;
+} Broadphase;
+
+bool BroadphaseInit(Broadphase *bp, float cellSize, int capacity);
+void BroadphaseFree(Broadphase *bp);
+void BroadphaseClear(Broadphase *bp);
+
+// Inserts the entity or moves it if it is already present.
+// Returns false on allocation failure.
+bool BroadphaseSet(Broadphase *bp, int handle, float x, float y, float w,
+                   float h);
+// BroadphaseSet() for handles [first, first + n) from SoA arrays
+bool BroadphaseSetMany(Broadphase *bp, int first, int n, const float *x,
+                       const float *y, const float *w, const float *h);
+void BroadphaseRemove(Broadphase *bp, int handle);
+
+// Writes up to max handles overlapping the box to out and returns how many
+// were written. Stops early once max is reached, so max == 1 is an "any
+// overlap?" test.
+int BroadphaseQuery(const Broadphase *bp, float x, float y, float w, float h,
+                    int32_t *out, int max);
+// Every overlapping pair (a < b), up to max. Returns the number written.
+int BroadphasePairs(const Broadphase *bp, BroadphasePair *out, int max);
+
+#endif // BROADPHASE_H
@@ -0,0 +1,66 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Resource bundle: every asset in one indexed file, already decoded, so
+// loading is a memory map and a table lookup instead of a file open and a
+// WAV/PNG decode per asset.
+//
+// File layout, little endian:
+//   "RLBN" | u16 version | u16 entry count
+//   then count index entries of BUNDLE_ENTRY_SIZE bytes:
+//     char name[32] | u32 type | u32 offset | u32 size | u32 crc32
+//     | u32 meta[4]
+//   then the data, every entry aligned to BUNDLE_ALIGN bytes
+//
+// meta is the decoded layout: frameCount, sampleRate, sampleSize, channels
+// for waves; width, height, pixel format, mipmaps for images.
+
+#define BUNDLE_NAME_SIZE 32
+#define BUNDLE_ALIGN 64
+
+typedef enum {
+  BUNDLE_RAW,   // file bytes as-is
+  BUNDLE_WAVE,  // interleaved PCM samples
+  BUNDLE_IMAGE, // pixel data in the stored pixel format
+} BundleType;
+
+typedef struct {
+  char name[BUNDLE_NAME_SIZE]; // file name without the directory
+  BundleType type;
+  uint32_t meta[4];
+  const uint8_t *data; // points into the mapping
+  uint32_t size;
+  uint32_t crc;
+} BundleEntry;
+
+typedef struct {
+  const uint8_t *data; // memory-mapped file
+  size_t size;
+  BundleEntry *entries;
+  int count;
+  void *mapping;
+} Bundle;
+
+// Maps the bundle and reads its index. Entry data is only range checked,
+// BundleVerify() checks the contents.
+bool BundleOpen(Bundle *bundle, const char *path);
+void BundleClose(Bundle *bundle);
+const BundleEntry *BundleFind(const Bundle *bundle, const char *name);
+// Checks every entry's CRC. Reads all of the data, so it also faults the
+// mapping in; call it off the main thread.
+bool BundleVerify(const Bundle *bundle);
+
+typedef struct BundleWriter BundleWriter;
+
+BundleWriter *BundleWriterOpen(const char *path);
+// Copies the data, nothing is written until close
+bool BundleWriterAdd(BundleWriter *writer, const char *name, BundleType type,
+                     const uint32_t meta[4], const void *data, size_t size);
+// Writes the index and data. Returns false (and removes the file) on error.
+bool BundleWriterClose(BundleWriter *writer);
+
+#endif // BUNDLE_H
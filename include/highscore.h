@@ -0,0 +1,44 @@
+#ifndef HIGHSCORE_H
+#define HIGHSCORE_H
+
+#include <stdint.h>
+
+// High score persistence. Scores live in memory and are written by a
+// background thread (temp file + atomic rename), so the frame loop never
+// touches the disk.
+
+#define HIGHSCORE_FILE "highscore.dat"
+#define LEADERBOARD_SIZE 10
+// How often a dirty record is written while a run is in progress
+#define HIGHSCORE_FLUSH_INTERVAL 5.0f
+
+typedef struct {
+  int32_t score;
+  int64_t timestamp; // seconds since the epoch
+} ScoreEntry;
+
+typedef struct HighScoreStore HighScoreStore;
+
+// Loads the record (falls back to an empty board if it is missing or
+// corrupt) and starts the writer thread. Returns NULL on allocation failure.
+HighScoreStore *HighScoreOpen(const char *path, float flushInterval);
+// Writes any pending changes, stops the writer thread and frees the store.
+// A run still in progress is recorded as if it had ended.
+void HighScoreClose(HighScoreStore *store);
+
+// Best score on record, including the run in progress
+int HighScoreBest(HighScoreStore *store);
+// Reports the score of the run in progress. Cheap, call it every frame.
+void HighScoreSubmit(HighScoreStore *store, int score);
+// Ends the run in progress, puts it on the leaderboard and schedules a write
+void HighScoreRecordGame(HighScoreStore *store, int score);
+// Forgets the run in progress (it became assisted), including any
+// provisional copy already on disk
+void HighScoreDiscardLive(HighScoreStore *store);
+// Schedules a write without waiting for it
+void HighScoreFlush(HighScoreStore *store);
+
+// Copies up to max entries, best first. Returns the number copied.
+int HighScoreLeaderboard(HighScoreStore *store, ScoreEntry *out, int max);
+
+#endif // HIGHSCORE_H
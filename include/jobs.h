@@ -0,0 +1,26 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+// Work-stealing job pool. JobPoolRun() splits an index range into chunks
+// that workers pop from their own Chase-Lev deque and steal from each
+// other's when they run dry. Big chunks are split in half on pop, so
+// idle workers always have something to steal.
+
+// Called for every index in [begin, end). worker is in [0, workers) and is
+// stable for the duration of the call, use it to pick per-thread state.
+typedef void (*JobFn)(void *ctx, int begin, int end, int worker);
+
+typedef struct JobPool JobPool;
+
+// Starts workers - 1 threads, the caller of JobPoolRun() is worker 0
+JobPool *JobPoolCreate(int workers);
+void JobPoolDestroy(JobPool *pool);
+int JobPoolWorkers(const JobPool *pool);
+
+// Runs fn over [0, count) in chunks of at most grain indices and waits
+// for all of them
+void JobPoolRun(JobPool *pool, int count, int grain, JobFn fn, void *ctx);
+
+int JobHardwareThreads(void);
+
+#endif // JOBS_H
@@ -0,0 +1,52 @@
+#ifndef OBSTACLES_H
+#define OBSTACLES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Structure-of-arrays obstacle storage. Live obstacles are always packed in
+// [0, count) and are recycled in place when they land, so the kernels below
+// never test an "active" flag.
+// All arrays share one allocation.
+
+typedef struct {
+  float *x;
+  float *y;
+  float *w;
+  float *h;
+  float *speed;
+  uint8_t *color;
+  int32_t *scratch; // index output for ObstaclesFindBelow()
+  int count;
+  int capacity;
+  void *block;
+} ObstacleStore;
+
+bool ObstacleStoreInit(ObstacleStore *store, int capacity);
+void ObstacleStoreFree(ObstacleStore *store);
+// Grows the store, keeping its contents. Returns false on allocation failure.
+bool ObstacleStoreReserve(ObstacleStore *store, int capacity);
+
+// Appends an obstacle (growing if needed). Returns its index or -1.
+int ObstacleStorePush(ObstacleStore *store, float x, float y, float w,
+                      float h, float speed, uint8_t color);
+
+// y += speed * frames for every live obstacle
+void ObstaclesIntegrate(ObstacleStore *store, float frames);
+// Writes the indices of obstacles with y > limit to store->scratch in
+// ascending order and returns how many there are
+int ObstaclesFindBelow(ObstacleStore *store, float limit);
+// Index of the first obstacle overlapping the rectangle, or -1
+int ObstaclesFirstOverlap(const ObstacleStore *store, float x, float y,
+                          float w, float h);
+
+// Scalar reference versions of the kernels, for benchmarks
+void ObstaclesIntegrateScalar(ObstacleStore *store, float frames);
+int ObstaclesFindBelowScalar(ObstacleStore *store, float limit);
+int ObstaclesFirstOverlapScalar(const ObstacleStore *store, float x, float y,
+                                float w, float h);
+
+// "avx2", "sse2" or "scalar", whichever the kernels were compiled for
+const char *ObstacleKernelName(void);
+
+#endif // OBSTACLES_H
@@ -0,0 +1,58 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Structure-of-arrays particle storage, laid out like ObstacleStore: live
+// particles are packed in [0, count) and expiring one swaps the last one
+// into its slot. Every particle is a fading circle:
+//   x, y     += vx, vy * frames
+//   radius   += growth * frames
+//   alpha    -= fade * frames, expired once it reaches 0
+// All arrays share one allocation.
+
+typedef struct {
+  float x, y;
+  float vx, vy;
+  float radius, growth;
+  float alpha, fade;
+  uint8_t color; // index into the renderer's palette
+} Particle;
+
+typedef struct {
+  float *x;
+  float *y;
+  float *vx;
+  float *vy;
+  float *radius;
+  float *growth;
+  float *alpha;
+  float *fade;
+  uint8_t *color;
+  int32_t *scratch; // index output for ParticlesExpire()
+  int count;
+  int capacity;
+  void *block;
+} ParticleStore;
+
+bool ParticleStoreInit(ParticleStore *store, int capacity);
+void ParticleStoreFree(ParticleStore *store);
+// Grows the store, keeping its contents. Returns false on allocation failure.
+bool ParticleStoreReserve(ParticleStore *store, int capacity);
+
+// Appends a particle (growing if needed). Returns its index or -1.
+int ParticleStorePush(ParticleStore *store, const Particle *particle);
+// O(1) swap-remove, the last particle takes index i
+void ParticleStoreRemove(ParticleStore *store, int i);
+
+// Advances every live particle by frames
+void ParticlesIntegrate(ParticleStore *store, float frames);
+// Removes every particle with alpha <= 0. Returns how many were removed.
+int ParticlesExpire(ParticleStore *store);
+
+// Scalar reference versions of the kernels, for benchmarks
+void ParticlesIntegrateScalar(ParticleStore *store, float frames);
+int ParticlesExpireScalar(ParticleStore *store);
+
+#endif // PARTICLES_H
@@ -0,0 +1,102 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame profiler. Zones are timed with a monotonic high resolution clock and
+// summed per frame into a lock-free ring of the last PROFILER_HISTORY
+// frames. Individual zone events also go into a ring for trace export.
+// Recording is safe from any thread; ProfilerEndFrame() belongs to the
+// render thread.
+//
+// The PROFILE_* macros compile to nothing unless RAYLIBLEARN_PROFILER is
+// defined (the CMake option of the same name, off by default).
+
+#define PROFILER_HISTORY 256
+#define PROFILER_MAX_EVENTS (1 << 16)
+
+typedef enum {
+  PROFILE_FRAME, // whole frame, measured between ProfilerEndFrame() calls
+  PROFILE_SIM,   // all SimStep() calls of the frame
+  PROFILE_SPAWN,
+  PROFILE_INPUT,
+  PROFILE_POWERUPS,
+  PROFILE_INVINCIBILITY,
+  PROFILE_OBSTACLES,
+  PROFILE_PARTICLES,
+  PROFILE_DRAW,
+  PROFILE_AUTOPILOT,
+  PROFILE_ZONE_COUNT
+} ProfileZone;
+
+typedef struct {
+  uint64_t frame;
+  uint64_t zoneNs[PROFILE_ZONE_COUNT];
+  uint32_t drawCalls;
+} ProfileFrame;
+
+typedef struct {
+  double p50Ms;
+  double p99Ms;
+} ProfileStats;
+
+uint64_t ProfilerNow(void); // nanoseconds, monotonic
+void ProfilerRecord(ProfileZone zone, uint64_t startNs);
+void ProfilerCountDraws(uint32_t count);
+// Publishes the finished frame to the history ring
+void ProfilerEndFrame(void);
+// Ignores zones recorded on the calling thread until resumed (e.g. while
+// simulating hypothetical futures)
+void ProfilerSuspend(bool suspend);
+
+const char *ProfilerZoneName(ProfileZone zone);
+// Percentiles of each zone over the recorded history. Returns the number of
+// frames they were computed from.
+int ProfilerStats(ProfileStats stats[PROFILE_ZONE_COUNT],
+                  ProfileStats *drawCalls);
+// Per-frame totals as CSV, and the recent zone events as Chrome trace JSON
+// (load in chrome://tracing or ui.perfetto.dev)
+bool ProfilerExportCsv(const char *path);
+bool ProfilerExportTrace(const char *path);
+
+#ifdef RAYLIBLEARN_PROFILER
+
+#define PROFILE_BEGIN(zone) uint64_t profileStart_##zone = ProfilerNow()
+#define PROFILE_END(zone) ProfilerRecord(zone, profileStart_##zone)
+#define PROFILE_COUNT_DRAWS(count) ProfilerCountDraws(count)
+#define PROFILE_END_FRAME() ProfilerEndFrame()
+#define PROFILE_SUSPEND() ProfilerSuspend(true)
+#define PROFILE_RESUME() ProfilerSuspend(false)
+
+#if defined(__GNUC__)
+// Times the rest of the enclosing block
+typedef struct {
+  ProfileZone zone;
+  uint64_t start;
+} ProfileScope;
+
+static inline void ProfileScopeEnd(ProfileScope *scope) {
+  ProfilerRecord(scope->zone, scope->start);
+}
+
+#define PROFILE_ZONE(zone)                                                     \
+  ProfileScope profileScope_##zone                                             \
+      __attribute__((cleanup(ProfileScopeEnd))) = {zone, ProfilerNow()}
+#else
+#define PROFILE_ZONE(zone) ((void)0)
+#endif
+
+#else
+
+#define PROFILE_BEGIN(zone) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+#define PROFILE_COUNT_DRAWS(count) ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#define PROFILE_SUSPEND() ((void)0)
+#define PROFILE_RESUME() ((void)0)
+#define PROFILE_ZONE(zone) ((void)0)
+
+#endif // RAYLIBLEARN_PROFILER
+
+#endif // PROFILER_H
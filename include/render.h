@@ -0,0 +1,162 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Retained draw command buffer. A frame records its draws into a
+// RenderList instead of drawing immediately; RenderFlush() then sorts them
+// by layer, primitive and texture and hands the backend one batch per run
+// of commands that can share a draw call. Layers keep their order, and so
+// do the commands inside a batch, so sorting never changes what overlaps
+// what within a layer's primitive.
+//
+// The command buffer and the text arena are kept between frames and only
+// grow, so steady-state frames allocate nothing. No raylib dependency: the
+// game supplies a raylib backend, headless tools use the null backend.
+
+typedef struct {
+  uint8_t r, g, b, a; // same layout as raylib's Color
+} RenderColor;
+
+#define RENDER_WHITE ((RenderColor){255, 255, 255, 255})
+#define RENDER_BLACK ((RenderColor){0, 0, 0, 255})
+#define RENDER_RAYWHITE ((RenderColor){245, 245, 245, 255})
+#define RENDER_GRAY ((RenderColor){130, 130, 130, 255})
+#define RENDER_DARKGRAY ((RenderColor){80, 80, 80, 255})
+#define RENDER_YELLOW ((RenderColor){253, 249, 0, 255})
+#define RENDER_GOLD ((RenderColor){255, 203, 0, 255})
+#define RENDER_ORANGE ((RenderColor){255, 161, 0, 255})
+#define RENDER_RED ((RenderColor){230, 41, 55, 255})
+#define RENDER_MAROON ((RenderColor){190, 33, 55, 255})
+#define RENDER_DARKGREEN ((RenderColor){0, 117, 44, 255})
+#define RENDER_BLUE ((RenderColor){0, 121, 241, 255})
+
+// Drawn in this order, whatever order they were recorded in
+typedef enum {
+  RENDER_LAYER_WORLD,
+  RENDER_LAYER_EFFECTS,
+  RENDER_LAYER_HUD,
+  RENDER_LAYER_OVERLAY,
+  RENDER_LAYER_COUNT
+} RenderLayer;
+
+// Within a layer, in this order
+typedef enum {
+  RENDER_RECT,
+  RENDER_RECT_LINES,
+  RENDER_CIRCLE,
+  RENDER_TEXTURE,
+  RENDER_TEXT,
+  RENDER_PRIMITIVE_COUNT
+} RenderPrimitive;
+
+// A texture as the backend knows it (raylib's Texture2D id and size)
+typedef struct {
+  uint32_t id;
+  uint16_t width, height;
+} RenderImage;
+
+typedef struct {
+  // Destination rectangle. Circles are centred on x, y with radius width,
+  // text is drawn at x, y with font size width.
+  float x, y, width, height;
+  float sourceX, sourceY, sourceWidth, sourceHeight; // textures only
+  RenderImage image;                                // textures only
+  uint32_t text; // offset into the text arena, text only
+  RenderColor color;
+  uint8_t primitive;
+  uint8_t layer;
+} RenderCommand;
+
+typedef struct {
+  int commands;
+  int batches;
+  // Batches the commands would have needed in recording order, what
+  // immediate mode drawing costs
+  int unsortedBatches;
+  int dropped; // commands lost to allocation failures
+} RenderStats;
+
+typedef struct RenderList RenderList;
+
+typedef struct {
+  void *context;
+  void (*clear)(void *context, RenderColor color);
+  // count commands sharing a layer, primitive and texture, in order
+  void (*batch)(void *context, const RenderList *list,
+                const RenderCommand *commands, int count);
+} RenderBackend;
+
+struct RenderList {
+  RenderCommand *commands;
+  int count;
+  int capacity;
+  char *text;
+  size_t textUsed;
+  size_t textCapacity;
+  // Sort scratch, sized with the command buffer: batch key in the high
+  // half, command index in the low half
+  uint64_t *keys;
+  uint64_t *swap;
+  RenderCommand *sorted;
+  RenderColor clearColor;
+  int dropped;
+  RenderStats stats; // of the last flush
+};
+
+bool RenderListInit(RenderList *list);
+void RenderListFree(RenderList *list);
+
+// Starts recording a frame, dropping the previous frame's commands
+void RenderBegin(RenderList *list, RenderColor clear);
+void RenderRect(RenderList *list, RenderLayer layer, float x, float y,
+                float width, float height, RenderColor color);
+void RenderRectLines(RenderList *list, RenderLayer layer, float x, float y,
+                     float width, float height, RenderColor color);
+void RenderCircle(RenderList *list, RenderLayer layer, float x, float y,
+                  float radius, RenderColor color);
+// Draws the whole image stretched over the destination rectangle
+void RenderTexture(RenderList *list, RenderLayer layer, RenderImage image,
+                   float x, float y, float width, float height,
+                   RenderColor tint);
+// The text is copied, it only has to live until the call returns
+void RenderText(RenderList *list, RenderLayer layer, const char *text,
+                float x, float y, float size, RenderColor color);
+// Sorts and batches the recorded commands and draws them with the backend.
+// Returns the frame's counts, also kept in list->stats.
+RenderStats RenderFlush(RenderList *list, const RenderBackend *backend);
+
+const char *RenderCommandText(const RenderList *list,
+                              const RenderCommand *command);
+// raylib's Fade(): alpha scaled by a 0..1 factor
+RenderColor RenderFade(RenderColor color, float alpha);
+
+// Backend that draws nothing and counts what it was given
+typedef struct {
+  long long commands;
+  long long batches;
+  long long primitives[RENDER_PRIMITIVE_COUNT];
+  long long frames;
+} RenderNullCounts;
+
+RenderBackend RenderNullBackend(RenderNullCounts *counts);
+
+// A formatted HUD string that is rebuilt only when its value changes
+#define HUD_TEXT_SIZE 64
+
+typedef struct {
+  char text[HUD_TEXT_SIZE];
+  long long key; // the value at the precision it is shown with
+  bool valid;
+  int rebuilds;
+} HudText;
+
+const char *HudTextInt(HudText *hud, const char *format, int value);
+// format shows value with decimals digits ("%.1f" and 1), only changes at
+// that precision cause a rebuild
+const char *HudTextFloat(HudText *hud, const char *format, float value,
+                         int decimals);
+
+#endif // RENDER_H
@@ -0,0 +1,61 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "sim.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Deterministic replays. A replay is the game setup followed by the input of
+// every SimStep(), run-length encoded, and an end record holding SimHash()
+// of the final state. Feeding the inputs back into a freshly initialised
+// GameState must reproduce that hash exactly.
+//
+// File layout, little endian:
+//   "RLRP" | u16 version | u16 reserved | u64 seed | f32 width | f32 height
+//   | i32 swarm obstacles (0 = classic)
+//   then runs:  varint length (>0) | u8 input
+//   then end:   varint 0 | u64 steps | u64 final state hash
+
+typedef struct {
+  uint64_t seed;
+  float screenWidth;
+  float screenHeight;
+  int32_t swarmObstacles; // 0 for classic mode
+} ReplayHeader;
+
+typedef struct ReplayWriter ReplayWriter;
+
+// Starts a replay file. Returns NULL if it can't be created.
+ReplayWriter *ReplayWriterOpen(const char *path, const ReplayHeader *header);
+// Records the input of one SimStep(). Buffered, repeats only extend a run.
+void ReplayWriterAppend(ReplayWriter *writer, SimInput input);
+// Writes the end record for the final state and closes the file
+bool ReplayWriterClose(ReplayWriter *writer, const GameState *final);
+
+typedef struct {
+  ReplayHeader header;
+  const uint8_t *data; // memory-mapped file
+  size_t size;
+  size_t pos;
+  SimInput runInput;
+  uint64_t runLeft;
+  uint64_t steps; // inputs handed out so far
+
+  bool hasEnd; // set once the end record has been read
+  uint64_t endSteps;
+  uint64_t endHash;
+
+  void *mapping;
+} ReplayReader;
+
+bool ReplayReaderOpen(ReplayReader *reader, const char *path);
+void ReplayReaderClose(ReplayReader *reader);
+// Next step's input. Returns false at the end of the replay (or at a
+// truncated one, in which case hasEnd stays false).
+bool ReplayReaderNext(ReplayReader *reader, SimInput *input);
+
+// Sets up a GameState exactly as the recorded game started
+bool ReplayInitGame(const ReplayHeader *header, GameState *state);
+
+#endif // REPLAY_H
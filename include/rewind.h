@@ -0,0 +1,110 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "sim.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// State history for rewinding and for stepping through the ticks before a
+// collision. Every step's SimSnapshot goes into a ring of records inside a
+// fixed memory budget. Every keyframeInterval steps a record is a full
+// snapshot (a keyframe); in between, a record is the XOR against the
+// previous step. The XOR is taken per snapshot section with the bytes of
+// each float array split into planes, and its zero runs are run-length
+// encoded: only obstacle y positions, timers and a few fields change
+// between ticks, so most of it is zeros.
+//
+// Appending costs one snapshot encode, whatever the history length. When
+// the ring is full the oldest keyframe is dropped with its deltas. Seeking
+// decodes forward from the keyframe at or before the step, at most
+// keyframeInterval - 1 deltas.
+//
+// Records are numbered by step, one per RewindAppend() counted from init
+// (GameState.tick stands still on the game over screen, so it can't be
+// the key). Truncating moves the numbering back with the history.
+
+#define REWIND_KEYFRAME_INTERVAL 30
+
+typedef struct {
+  uint64_t step;
+  size_t offset; // of its record in the ring
+} RewindKeyframe;
+
+typedef struct {
+  // Record ring: [tail, head) wrapping, used counts the skipped end too
+  uint8_t *ring;
+  size_t ringSize;
+  size_t head;
+  size_t tail;
+  size_t used;
+  size_t newestOffset; // record of the newest step
+
+  // One keyframe per group of records, oldest first
+  RewindKeyframe *keyframes;
+  int keyframeCapacity;
+  int firstKeyframe;
+  int keyframeCount;
+  int keyframeInterval;
+
+  uint64_t oldestStep;
+  uint64_t newestStep;
+  uint64_t nextStep;
+  size_t budget;
+
+  // The newest step's snapshot (deltas are taken against it) and the one
+  // being encoded
+  SimSnapshot previous;
+  SimSnapshot current;
+  // Last seek result, later seeks in the same group continue from it
+  SimSnapshot decoded;
+  SimSnapshot decodeSwap;
+  uint64_t decodedStep;
+  size_t decodedOffset;
+  bool decodedValid;
+  uint8_t *scratch; // transposed XOR planes
+  uint8_t *encoded; // run-length encoded planes
+  size_t scratchCapacity;
+
+  // Since init, for the rates
+  uint64_t appended;
+  uint64_t appendedBytes;  // records written, headers included
+  uint64_t snapshotBytes;  // what full snapshots would have taken
+  uint64_t keyframeBytes;
+} RewindBuffer;
+
+typedef struct {
+  uint64_t oldestStep;
+  uint64_t newestStep;
+  int64_t steps; // held, 0 when empty
+  double seconds;
+  size_t bytesUsed;
+  size_t budget;
+  // History written per second of play (at SIM_TICK_RATE), and how many
+  // seconds of it the budget holds at that rate
+  double bytesPerSecond;
+  double secondsPerBudget;
+  double compression;   // full snapshot bytes per byte written
+  double keyframeShare; // of the bytes written
+} RewindStats;
+
+// budgetBytes covers the ring and its keyframe index. The encoder's working
+// snapshots come on top, a few times one snapshot.
+bool RewindInit(RewindBuffer *rewind, size_t budgetBytes,
+                int keyframeInterval);
+void RewindFree(RewindBuffer *rewind);
+void RewindClear(RewindBuffer *rewind);
+
+// Records the state after a SimStep() as step rewind->nextStep. Returns
+// false if the snapshot doesn't fit in the budget at all (the history is
+// empty then).
+bool RewindAppend(RewindBuffer *rewind, const GameState *state);
+bool RewindHas(const RewindBuffer *rewind, uint64_t step);
+// Overwrites an initialised state (same mode) with the stored step
+bool RewindSeek(RewindBuffer *rewind, uint64_t step, GameState *state);
+// Forgets every step after step, so play can go on from its state
+bool RewindTruncate(RewindBuffer *rewind, uint64_t step);
+
+RewindStats RewindGetStats(const RewindBuffer *rewind);
+
+#endif // REWIND_H
@@ -0,0 +1,35 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "render.h"
+#include "sim.h"
+
+// Records a frame of the game into a RenderList: effects, the player,
+// obstacles, power-ups and the in-game HUD. Shared by the game and the
+// headless render benchmark, so both measure the same command stream.
+
+typedef struct {
+  HudText score;
+  HudText highScore;
+  HudText speed;
+  HudText obstacles;
+  HudText invincible;
+} SceneHud;
+
+// powerUpImage is the texture drawn for power-ups
+void SceneRecord(RenderList *list, SceneHud *hud, const GameState *state,
+                 int highScore, RenderImage powerUpImage);
+// Draws the world alpha of the way from previous to state (0 is previous,
+// 1 is state), for a render thread that runs behind a sim thread. The
+// player is blended between the two; obstacles and particles are moved back
+// along their own speed instead, since a landed obstacle is recycled to the
+// top at the same index and an expired particle's index is taken by another.
+// Without a previous state of the same run it's SceneRecord().
+void SceneRecordInterpolated(RenderList *list, SceneHud *hud,
+                             const GameState *previous,
+                             const GameState *state, float alpha,
+                             int highScore, RenderImage powerUpImage);
+// HUD strings formatted so far, against 5 per frame without the cache
+int SceneHudRebuilds(const SceneHud *hud);
+
+#endif // SCENE_H
@@ -0,0 +1,200 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "broadphase.h"
+#include "obstacles.h"
+#include "particles.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Headless game simulation. Nothing in here touches raylib, so it can be
+// stepped (and benchmarked) without a window or an audio device.
+
+#define MAX_OBSTACLES 20
+#define INITIAL_OBSTACLES 2
+#define MAX_POWERUPS 5
+// Live particle limit, emitters drop particles past it
+#define SIM_MAX_PARTICLES (1 << 20)
+
+// Swarm mode: thousands of small obstacles from the first tick
+#define SIM_SWARM_OBSTACLES 10000
+#define SIM_SWARM_OBSTACLE_SIZE 8.0f
+
+// Fixed simulation rate. Every speed constant in the game was tuned as
+// "pixels per frame at 60 FPS", so movement is scaled by dt * SIM_TICK_RATE.
+#define SIM_TICK_RATE 60
+#define SIM_DT (1.0f / SIM_TICK_RATE)
+// Longest frame the accumulator will try to catch up on (avoids the spiral
+// of death after a breakpoint or a window drag)
+#define SIM_MAX_FRAME_TIME 0.25f
+
+#define SIM_PALETTE_SIZE 5
+// Renderer palette entries after the obstacle colors, used by effects
+#define SIM_COLOR_POWERUP SIM_PALETTE_SIZE
+#define SIM_COLOR_PLAYER (SIM_PALETTE_SIZE + 1)
+#define SIM_COLOR_COUNT (SIM_PALETTE_SIZE + 2)
+
+typedef struct {
+  float x;
+  float y;
+  float width;
+  float height;
+} SimRect;
+
+typedef struct {
+  float x;
+  float y;
+} SimVec2;
+
+// Per-tick input, one bit per action
+typedef enum {
+  SIM_INPUT_LEFT = 1 << 0,
+  SIM_INPUT_RIGHT = 1 << 1,
+  SIM_INPUT_UP = 1 << 2,
+  SIM_INPUT_DOWN = 1 << 3,
+  SIM_INPUT_RESTART = 1 << 4,
+} SimInputBits;
+
+typedef uint8_t SimInput;
+
+// Things that happened during the last SimStep() (sound triggers etc.)
+typedef enum {
+  SIM_EVENT_FLOOR_HIT,
+  SIM_EVENT_POWERUP,
+  SIM_EVENT_COLLISION,
+  SIM_EVENT_COUNT
+} SimEvent;
+
+// Particle emitters
+typedef enum {
+  SIM_EFFECT_FLOOR_HIT, // expanding ring where an obstacle left the screen
+  SIM_EFFECT_POWERUP,   // ring of sparks around a picked up power-up
+  SIM_EFFECT_COLLISION, // burst of debris from the player
+  SIM_EFFECT_COUNT
+} SimEffect;
+
+typedef struct {
+  SimRect rect;
+  SimVec2 speed;
+  int color; // index into the renderer's palette
+  bool active;
+} GameObject;
+
+typedef struct {
+  SimRect rect;
+  bool active;
+  float timer;
+  float duration;
+  int type; // Ex -> 0: Invincibility
+} PowerUp;
+
+typedef struct {
+  float screenWidth;
+  float screenHeight;
+  uint64_t rng;
+  uint64_t effectRng; // cosmetic only, keeps gameplay off the effect stream
+  uint64_t tick;
+
+  GameObject player;
+  ObstacleStore obstacles;
+  PowerUp powerUps[MAX_POWERUPS];
+  ParticleStore particles;
+
+  // Collision broadphases, handles are obstacle and power-up indices
+  Broadphase obstacleGrid;
+  Broadphase powerUpGrid;
+
+  // Obstacle field configuration, fixed at init
+  int initialObstacles;
+  int maxObstacles;
+  float obstacleSize;
+
+  // Difficulty curve, defaults set at init. Change them before the first
+  // step (or call SimReset()) to tune the game.
+  float startSpeed;      // baseSpeed at score 0
+  float speedRampScore;  // score for +1 baseSpeed
+  int obstacleScoreStep; // score between extra obstacles
+
+  int score;
+  float baseSpeed;
+  bool gameOver;
+  float timePlayed;
+  int nextObstacleScore;
+  bool isInvincible;
+  float invincibilityTimer;
+  float invincibilityDuration;
+  float powerUpSpawnTimer;
+  float powerUpSpawnInterval;
+
+  int events[SIM_EVENT_COUNT];
+} GameState;
+
+// A flat copy of everything SimStep() reads: the GameState fields followed
+// by the live obstacle and particle arrays, packed. The whole snapshot is
+// one block, so duplicating one is a single memcpy of size bytes. The
+// broadphases are derived data and are rebuilt on restore.
+typedef struct {
+  size_t size; // bytes used in data
+  size_t capacity;
+  uint8_t *data;
+} SimSnapshot;
+
+// Classic mode: two obstacles, one more every 500 points up to
+// MAX_OBSTACLES. Returns false on allocation failure.
+bool SimInit(GameState *state, float screenWidth, float screenHeight,
+             uint64_t seed);
+// Swarm mode: obstacleCount obstacles, spread above the screen at start
+bool SimInitSwarm(GameState *state, float screenWidth, float screenHeight,
+                  uint64_t seed, int obstacleCount);
+void SimFree(GameState *state);
+void SimReset(GameState *state);
+void SimResize(GameState *state, float screenWidth, float screenHeight);
+
+// Advances the game by dt seconds. Events are cleared at the start of every
+// step, so read state->events after each call.
+void SimStep(GameState *state, SimInput input, float dt);
+
+// The pieces of SimStep() on their own, for benchmarks and tools. Spawning
+// adds one obstacle above the screen (-1 once the mode's limit is reached)
+// or fills the first free power-up slot (-1 when all are taken). Emitting
+// returns the number of particles added.
+int SimSpawnObstacle(GameState *state);
+int SimSpawnPowerUp(GameState *state);
+int SimEmitParticles(GameState *state, SimEffect effect, float x, float y,
+                     int color);
+void SimUpdateParticles(GameState *state, float dt);
+
+// Captures the state into the snapshot, growing it if needed
+bool SimSnapshotSave(const GameState *state, SimSnapshot *snapshot);
+// Overwrites an initialised state (any mode) with the snapshot
+bool SimSnapshotRestore(GameState *state, const SimSnapshot *snapshot);
+bool SimSnapshotCopy(SimSnapshot *dst, const SimSnapshot *src);
+void SimSnapshotFree(SimSnapshot *snapshot);
+
+// A snapshot split into the GameState copy and one section per packed
+// array, for delta encoding. elementSize is 4 for float arrays, 1 for the
+// rest.
+#define SIM_SNAPSHOT_SECTIONS 16
+
+typedef struct {
+  size_t offset;
+  size_t size;
+  int elementSize;
+} SimSnapshotSection;
+
+// Only reads the GameState copy at the start of data, so it also works on a
+// snapshot that is still being decoded
+void SimSnapshotSections(const uint8_t *data,
+                         SimSnapshotSection sections[SIM_SNAPSHOT_SECTIONS]);
+
+// Per-state RNG, inclusive on both ends like raylib's GetRandomValue()
+int SimRandomValue(GameState *state, int min, int max);
+
+bool SimCheckCollision(SimRect a, SimRect b);
+
+// FNV-1a over everything that affects future ticks. Equal hashes after the
+// same inputs mean the simulation is deterministic.
+uint64_t SimHash(const GameState *state);
+
+#endif // SIM_H
@@ -0,0 +1,103 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include "sim.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Simulation on its own thread. It steps at SIM_TICK_RATE on an absolute
+// schedule, so a slow frame on the render thread no longer delays game
+// logic. Input reaches it through a single-producer single-consumer queue,
+// and every tick is published as a snapshot through a lock-free triple
+// buffer: the sim thread always has a free slot to write, the render thread
+// always reads the newest complete one, and neither ever waits for the
+// other. The render thread keeps the two newest states it took and draws
+// between them (see SceneRecordInterpolated()).
+//
+// SimTiming collects the input-to-display latency and tick jitter samples
+// that make this mode and the single-threaded one comparable.
+
+#define SIM_INPUT_QUEUE_SIZE 256 // power of two
+// Falling this many ticks behind drops them instead of catching up
+#define SIM_THREAD_MAX_LAG 5
+#define SIM_TIMING_WINDOW 512
+
+// Input as sampled on the render thread. Held buttons apply until the next
+// event, SIM_INPUT_RESTART applies to one tick.
+typedef struct {
+  SimInput input;
+  uint64_t timeNs; // ProfilerNow() when sampled
+} SimInputEvent;
+
+typedef struct {
+  SimInputEvent events[SIM_INPUT_QUEUE_SIZE];
+  // Each index has one writer, on its own cache line
+  _Alignas(64) _Atomic uint32_t head; // producer
+  _Alignas(64) _Atomic uint32_t tail; // consumer
+} SimInputQueue;
+
+void SimInputQueueInit(SimInputQueue *queue);
+// Producer side. Returns false when the queue is full.
+bool SimInputQueuePush(SimInputQueue *queue, SimInputEvent event);
+// Consumer side. Returns false when the queue is empty.
+bool SimInputQueuePop(SimInputQueue *queue, SimInputEvent *event);
+
+// Rolling window of millisecond samples
+typedef struct {
+  float ms[SIM_TIMING_WINDOW];
+  int count;
+  int next;
+  long long total; // samples ever added
+} SimTiming;
+
+typedef struct {
+  double p50Ms;
+  double p99Ms;
+  double maxMs;
+  long long samples;
+} SimTimingStats;
+
+void SimTimingAdd(SimTiming *timing, double ms);
+SimTimingStats SimTimingGet(const SimTiming *timing);
+// Adds how far the interval since *lastTickNs was from SIM_DT and moves
+// *lastTickNs to nowNs. Nothing is added while *lastTickNs is 0 (set it to
+// 0 across a pause).
+void SimTimingAddTick(SimTiming *jitter, uint64_t *lastTickNs,
+                      uint64_t nowNs);
+// Sleeps until ProfilerNow() reaches ns
+void SimSleepUntil(uint64_t ns);
+
+// A published tick, as handed to the render thread
+typedef struct {
+  uint64_t step;   // ticks since the thread started, 0 for the start state
+  uint64_t tickNs; // when the tick was scheduled
+  // Newest input event the tick consumed, 0 if none yet. Display time
+  // minus this is the input latency.
+  uint64_t inputNs;
+  // Summed over every tick since the render thread last took a frame, so
+  // no sound or score is lost when frames are skipped
+  int events[SIM_EVENT_COUNT];
+  // Tick interval deviation from SIM_DT, refreshed once a second
+  SimTimingStats jitter;
+} SimFrameInfo;
+
+typedef struct SimThread SimThread;
+
+// Takes over the state and starts stepping it. The caller must not touch
+// it again until SimThreadStop(). Returns NULL on failure.
+SimThread *SimThreadStart(GameState *state);
+// Stops and joins the thread, the state is left at the last tick
+void SimThreadStop(SimThread *thread);
+
+// Render thread only. Returns false if the input queue is full.
+bool SimThreadPush(SimThread *thread, SimInput input, uint64_t timeNs);
+// Stops ticking while the game is running (not on the game over screen)
+void SimThreadPause(SimThread *thread, bool paused);
+// Restores the newest published tick into state if there is one the render
+// thread hasn't taken yet. Returns false if nothing new was published, or
+// if restoring failed; that tick's events then come with the next one.
+bool SimThreadAcquire(SimThread *thread, GameState *state,
+                      SimFrameInfo *info);
+
+#endif // SIMTHREAD_H
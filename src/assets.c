@@ -0,0 +1,198 @@
+#define _POSIX_C_SOURCE 200809L
+#include "assets.h"
+
+#include "bundle.h"
+#include "profiler.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *const gameAssetNames[ASSET_COUNT] = {
+    [ASSET_COLLISION_SOUND] = "collision.wav",
+    [ASSET_POWERUP_SOUND] = "powerup.wav",
+    [ASSET_FLOOR_HIT_SOUND] = "floorhit.wav",
+    [ASSET_STAR_TEXTURE] = "star.png",
+};
+
+struct AssetLoader {
+  pthread_t thread;
+  bool joined;
+  atomic_int loaded;
+  atomic_bool ready;
+
+  char bundlePath[512];
+  char fallbackDir[512];
+  char names[MAX_ASSETS][BUNDLE_NAME_SIZE];
+  int count;
+
+  Bundle bundle;
+  bool fromBundle;
+  Wave waves[MAX_ASSETS];
+  Image images[MAX_ASSETS];
+  bool owned[MAX_ASSETS]; // decoded by raylib, not pointing into the bundle
+
+  uint64_t startNs;
+  uint64_t readyNs;
+};
+
+// raylib's IsFileExtension() goes through a shared static buffer, this runs
+// next to the main thread
+static bool IsAudioFile(const char *name) {
+  static const char *const extensions[] = {".wav", ".ogg", ".mp3", ".flac",
+                                           ".qoa"};
+  const char *dot = strrchr(name, '.');
+  if (!dot)
+    return false;
+  char ext[8] = {0};
+  for (int i = 0; i < (int)sizeof(ext) - 1 && dot[i]; i++)
+    ext[i] = (char)tolower((unsigned char)dot[i]);
+  for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++) {
+    if (strcmp(ext, extensions[i]) == 0)
+      return true;
+  }
+  return false;
+}
+
+static void LoadFromBundle(AssetLoader *loader, int i,
+                           const BundleEntry *entry) {
+  // The data stays in the mapping, raylib only reads it
+  if (entry->type == BUNDLE_WAVE) {
+    loader->waves[i] = (Wave){.frameCount = entry->meta[0],
+                              .sampleRate = entry->meta[1],
+                              .sampleSize = entry->meta[2],
+                              .channels = entry->meta[3],
+                              .data = (void *)entry->data};
+  } else if (entry->type == BUNDLE_IMAGE) {
+    loader->images[i] = (Image){.data = (void *)entry->data,
+                                .width = (int)entry->meta[0],
+                                .height = (int)entry->meta[1],
+                                .format = (int)entry->meta[2],
+                                .mipmaps = (int)entry->meta[3]};
+  }
+}
+
+static void LoadFromFile(AssetLoader *loader, int i) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s", loader->fallbackDir,
+           loader->names[i]);
+  if (IsAudioFile(path))
+    loader->waves[i] = LoadWave(path);
+  else
+    loader->images[i] = LoadImage(path);
+  loader->owned[i] = true;
+}
+
+static void *LoadThread(void *arg) {
+  AssetLoader *loader = arg;
+  if (loader->bundlePath[0] &&
+      BundleOpen(&loader->bundle, loader->bundlePath)) {
+    // Checking the CRCs also pulls the whole mapping in, here rather than
+    // on the main thread's first touch
+    loader->fromBundle = BundleVerify(&loader->bundle);
+    if (!loader->fromBundle) {
+      fprintf(stderr, "%s is corrupt, loading loose files\n",
+              loader->bundlePath);
+      BundleClose(&loader->bundle);
+    }
+  }
+
+  for (int i = 0; i < loader->count; i++) {
+    const BundleEntry *entry =
+        loader->fromBundle ? BundleFind(&loader->bundle, loader->names[i])
+                           : NULL;
+    if (entry)
+      LoadFromBundle(loader, i, entry);
+    else
+      LoadFromFile(loader, i);
+    atomic_fetch_add_explicit(&loader->loaded, 1, memory_order_relaxed);
+  }
+
+  loader->readyNs = ProfilerNow();
+  atomic_store_explicit(&loader->ready, true, memory_order_release);
+  return NULL;
+}
+
+AssetLoader *AssetsLoadAsync(const char *bundlePath, const char *fallbackDir,
+                             const char *const names[], int count) {
+  if (count > MAX_ASSETS)
+    return NULL;
+  AssetLoader *loader = calloc(1, sizeof(AssetLoader));
+  if (!loader)
+    return NULL;
+  snprintf(loader->bundlePath, sizeof(loader->bundlePath), "%s",
+           bundlePath ? bundlePath : "");
+  snprintf(loader->fallbackDir, sizeof(loader->fallbackDir), "%s",
+           fallbackDir);
+  for (int i = 0; i < count; i++)
+    snprintf(loader->names[i], BUNDLE_NAME_SIZE, "%s", names[i]);
+  loader->count = count;
+  atomic_init(&loader->loaded, 0);
+  atomic_init(&loader->ready, false);
+
+  loader->startNs = ProfilerNow();
+  if (pthread_create(&loader->thread, NULL, LoadThread, loader) != 0) {
+    free(loader);
+    return NULL;
+  }
+  return loader;
+}
+
+bool AssetsReady(AssetLoader *loader) {
+  return atomic_load_explicit(&loader->ready, memory_order_acquire);
+}
+
+float AssetsProgress(AssetLoader *loader) {
+  if (loader->count == 0)
+    return 1.0f;
+  return (float)atomic_load_explicit(&loader->loaded, memory_order_relaxed) /
+         loader->count;
+}
+
+void AssetsWait(AssetLoader *loader) {
+  if (!loader->joined) {
+    pthread_join(loader->thread, NULL);
+    loader->joined = true;
+  }
+}
+
+bool AssetsFromBundle(AssetLoader *loader) { return loader->fromBundle; }
+
+double AssetsLoadMs(AssetLoader *loader) {
+  return (loader->readyNs - loader->startNs) / 1e6;
+}
+
+Wave AssetsWave(AssetLoader *loader, int index) {
+  return loader->waves[index];
+}
+
+Image AssetsImage(AssetLoader *loader, int index) {
+  return loader->images[index];
+}
+
+Sound AssetsSound(AssetLoader *loader, int index) {
+  Wave wave = loader->waves[index];
+  return wave.data ? LoadSoundFromWave(wave) : (Sound){0};
+}
+
+Texture2D AssetsTexture(AssetLoader *loader, int index) {
+  Image image = loader->images[index];
+  return image.data ? LoadTextureFromImage(image) : (Texture2D){0};
+}
+
+void AssetsClose(AssetLoader *loader) {
+  AssetsWait(loader);
+  for (int i = 0; i < loader->count; i++) {
+    if (!loader->owned[i])
+      continue;
+    if (loader->waves[i].data)
+      UnloadWave(loader->waves[i]);
+    if (loader->images[i].data)
+      UnloadImage(loader->images[i]);
+  }
+  if (loader->fromBundle)
+    BundleClose(&loader->bundle);
+  free(loader);
+}
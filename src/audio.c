@@ -0,0 +1,272 @@
+#define _POSIX_C_SOURCE 200809L
+#include "audio.h"
+
+#include "profiler.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+const AudioSoundConfig audioGameSounds[SIM_EVENT_COUNT] = {
+    // Swarm mode drops dozens of obstacles a second, a few overlapping
+    // thuds are enough
+    [SIM_EVENT_FLOOR_HIT] = {.priority = 0,
+                             .maxVoices = 3,
+                             .coalesceMs = 60.0f,
+                             .durationMs = 250.0f},
+    [SIM_EVENT_POWERUP] = {.priority = 1,
+                           .maxVoices = 2,
+                           .coalesceMs = 30.0f,
+                           .durationMs = 500.0f},
+    // Always heard
+    [SIM_EVENT_COLLISION] = {.priority = 2,
+                             .maxVoices = 1,
+                             .coalesceMs = 100.0f,
+                             .durationMs = 800.0f},
+};
+
+typedef struct {
+  uint64_t timeNs;
+  int32_t count;
+  uint8_t sound;
+} AudioEvent;
+
+typedef struct {
+  uint64_t endNs;
+  int sound;
+  int slot; // voice of the sound, as passed to the backend
+  int priority;
+  bool active;
+} Voice;
+
+struct AudioMixer {
+  pthread_t thread;
+  atomic_bool quit;
+  AudioBackend backend;
+
+  AudioSoundConfig sounds[AUDIO_MAX_SOUNDS];
+  int soundCount;
+  int maxVoices;
+
+  // Single producer, single consumer
+  AudioEvent events[AUDIO_QUEUE_SIZE];
+  _Alignas(64) _Atomic uint32_t head; // posting thread
+  _Alignas(64) _Atomic uint32_t tail; // dispatch thread
+
+  // Posting thread only
+  long long posted;
+  long long queueDrops;
+
+  // Dispatch thread only
+  Voice voices[AUDIO_MAX_VOICES];
+  uint64_t lastPlayNs[AUDIO_MAX_SOUNDS]; // 0 before the first play
+  AudioStats dispatched;
+
+  // Copy of dispatched for other threads, refreshed after every drain
+  pthread_mutex_t lock;
+  AudioStats published;
+};
+
+static uint64_t MsToNs(float ms) { return (uint64_t)(ms * 1e6f); }
+
+// Frees the voices whose play has ended
+static void ExpireVoices(AudioMixer *mixer, uint64_t now) {
+  for (int i = 0; i < mixer->maxVoices; i++) {
+    Voice *voice = &mixer->voices[i];
+    if (voice->active && voice->endNs <= now) {
+      voice->active = false;
+      mixer->dispatched.activeVoices--;
+    }
+  }
+}
+
+// Global voice to play a sound of the given priority on: a free one, or the
+// lowest priority voice below it, the one closest to its end among equals.
+// -1 if there is none.
+static int PickVoice(const AudioMixer *mixer, int priority) {
+  int victim = -1;
+  for (int i = 0; i < mixer->maxVoices; i++) {
+    const Voice *voice = &mixer->voices[i];
+    if (!voice->active)
+      return i;
+    if (voice->priority >= priority)
+      continue;
+    const Voice *best = victim >= 0 ? &mixer->voices[victim] : NULL;
+    if (!best || voice->priority < best->priority ||
+        (voice->priority == best->priority && voice->endNs < best->endNs))
+      victim = i;
+  }
+  return victim;
+}
+
+static void Dispatch(AudioMixer *mixer, const AudioEvent *event, uint64_t now) {
+  AudioStats *stats = &mixer->dispatched;
+  const AudioSoundConfig *config = &mixer->sounds[event->sound];
+  uint64_t last = mixer->lastPlayNs[event->sound];
+  if (last && event->timeNs - last < MsToNs(config->coalesceMs)) {
+    stats->coalesced += event->count;
+    return;
+  }
+  // One play for the event, its other triggers merge into it
+  stats->coalesced += event->count - 1;
+
+  // A free voice of the sound (its own limit)
+  bool used[AUDIO_MAX_VOICES] = {false};
+  for (int i = 0; i < mixer->maxVoices; i++) {
+    const Voice *voice = &mixer->voices[i];
+    if (voice->active && voice->sound == event->sound)
+      used[voice->slot] = true;
+  }
+  int slot = 0;
+  while (slot < config->maxVoices && used[slot])
+    slot++;
+  int index = slot < config->maxVoices ? PickVoice(mixer, config->priority)
+                                       : -1;
+  if (index < 0) {
+    stats->voiceDrops++;
+    return;
+  }
+
+  Voice *voice = &mixer->voices[index];
+  if (voice->active) {
+    mixer->backend.stop(mixer->backend.context, voice->sound, voice->slot);
+    stats->stolen++;
+  } else {
+    stats->activeVoices++;
+  }
+  *voice = (Voice){now + MsToNs(config->durationMs), event->sound, slot,
+                   config->priority, true};
+  mixer->backend.play(mixer->backend.context, event->sound, slot);
+  mixer->lastPlayNs[event->sound] = event->timeNs;
+  stats->played++;
+  if (stats->activeVoices > stats->peakVoices)
+    stats->peakVoices = stats->activeVoices;
+}
+
+static bool PopEvent(AudioMixer *mixer, AudioEvent *event) {
+  uint32_t tail = atomic_load_explicit(&mixer->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&mixer->head, memory_order_acquire);
+  if (head == tail)
+    return false;
+  *event = mixer->events[tail % AUDIO_QUEUE_SIZE];
+  atomic_store_explicit(&mixer->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+static void *DispatchThread(void *arg) {
+  AudioMixer *mixer = arg;
+  struct timespec interval = {0, AUDIO_DISPATCH_MS * 1000000L};
+  for (;;) {
+    // Read first, so the drain after a close request gets everything
+    bool quit = atomic_load_explicit(&mixer->quit, memory_order_acquire);
+    uint64_t now = ProfilerNow();
+    ExpireVoices(mixer, now);
+    AudioEvent event;
+    while (PopEvent(mixer, &event))
+      Dispatch(mixer, &event, now);
+
+    pthread_mutex_lock(&mixer->lock);
+    mixer->published = mixer->dispatched;
+    pthread_mutex_unlock(&mixer->lock);
+    if (quit)
+      return NULL;
+    while (nanosleep(&interval, &interval) == -1 && errno == EINTR)
+      ;
+    interval = (struct timespec){0, AUDIO_DISPATCH_MS * 1000000L};
+  }
+}
+
+AudioMixer *AudioMixerOpen(const AudioSoundConfig *sounds, int count,
+                           int maxVoices, AudioBackend backend) {
+  if (count < 1 || count > AUDIO_MAX_SOUNDS || maxVoices < 1 ||
+      maxVoices > AUDIO_MAX_VOICES)
+    return NULL;
+  AudioMixer *mixer = calloc(1, sizeof(AudioMixer));
+  if (!mixer)
+    return NULL;
+  for (int i = 0; i < count; i++) {
+    mixer->sounds[i] = sounds[i];
+    int limit = sounds[i].maxVoices;
+    mixer->sounds[i].maxVoices =
+        limit < 1 ? 1 : (limit > AUDIO_MAX_VOICES ? AUDIO_MAX_VOICES : limit);
+  }
+  mixer->soundCount = count;
+  mixer->maxVoices = maxVoices;
+  mixer->backend = backend;
+  atomic_init(&mixer->quit, false);
+  atomic_init(&mixer->head, 0);
+  atomic_init(&mixer->tail, 0);
+
+  pthread_mutex_init(&mixer->lock, NULL);
+  if (pthread_create(&mixer->thread, NULL, DispatchThread, mixer) != 0) {
+    pthread_mutex_destroy(&mixer->lock);
+    free(mixer);
+    return NULL;
+  }
+  return mixer;
+}
+
+void AudioMixerClose(AudioMixer *mixer, AudioStats *stats) {
+  if (!mixer)
+    return;
+  atomic_store_explicit(&mixer->quit, true, memory_order_release);
+  pthread_join(mixer->thread, NULL);
+  if (stats)
+    *stats = AudioMixerStats(mixer);
+  pthread_mutex_destroy(&mixer->lock);
+  free(mixer);
+}
+
+bool AudioPost(AudioMixer *mixer, int sound, int count) {
+  if (sound < 0 || sound >= mixer->soundCount || count < 1)
+    return false;
+  mixer->posted += count;
+  uint32_t head = atomic_load_explicit(&mixer->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&mixer->tail, memory_order_acquire);
+  if (head - tail == AUDIO_QUEUE_SIZE) {
+    mixer->queueDrops += count;
+    return false;
+  }
+  mixer->events[head % AUDIO_QUEUE_SIZE] =
+      (AudioEvent){ProfilerNow(), count, (uint8_t)sound};
+  atomic_store_explicit(&mixer->head, head + 1, memory_order_release);
+  return true;
+}
+
+AudioStats AudioMixerStats(AudioMixer *mixer) {
+  pthread_mutex_lock(&mixer->lock);
+  AudioStats stats = mixer->published;
+  pthread_mutex_unlock(&mixer->lock);
+  stats.posted = mixer->posted;
+  stats.queueDrops = mixer->queueDrops;
+  return stats;
+}
+
+static void NullPlay(void *context, int sound, int voice) {
+  (void)voice;
+  AudioNullCounts *counts = context;
+  counts->plays[sound]++;
+}
+
+static void NullStop(void *context, int sound, int voice) {
+  (void)voice;
+  AudioNullCounts *counts = context;
+  counts->stops[sound]++;
+}
+
+AudioBackend AudioNullBackend(AudioNullCounts *counts) {
+  return (AudioBackend){counts, NullPlay, NullStop};
+}
+
+static void FilePlay(void *context, int sound, int voice) {
+  fprintf(context, "%.3f,play,%d,%d\n", ProfilerNow() / 1e6, sound, voice);
+}
+
+static void FileStop(void *context, int sound, int voice) {
+  fprintf(context, "%.3f,stop,%d,%d\n", ProfilerNow() / 1e6, sound, voice);
+}
+
+AudioBackend AudioFileBackend(FILE *file) {
+  return (AudioBackend){file, FilePlay, FileStop};
+}
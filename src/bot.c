@@ -0,0 +1,179 @@
+#include "bot.h"
+
+#include "profiler.h"
+#include <string.h>
+#include <time.h>
+
+// How far above the player the reflex bot looks, in player heights
+#define BOT_LOOKAHEAD 6.0f
+#define BOT_MAX_THREATS 64
+
+SimInput BotReflex(const GameState *state) {
+  SimInput input = 0;
+  if (state->gameOver)
+    return SIM_INPUT_RESTART;
+
+  const SimRect *player = &state->player.rect;
+  float center = player->x + player->width / 2;
+  float margin = player->width;
+
+  // Nearest obstacle coming down on us
+  int32_t threats[BOT_MAX_THREATS];
+  int n = BroadphaseQuery(&state->obstacleGrid, player->x - margin,
+                          player->y - player->height * BOT_LOOKAHEAD,
+                          player->width + 2 * margin,
+                          player->height * (BOT_LOOKAHEAD + 1), threats,
+                          BOT_MAX_THREATS);
+  const ObstacleStore *obstacles = &state->obstacles;
+  int nearest = -1;
+  for (int k = 0; k < n; k++) {
+    int i = threats[k];
+    if (nearest < 0 || obstacles->y[i] > obstacles->y[nearest])
+      nearest = i;
+  }
+
+  if (nearest >= 0) {
+    float threat = obstacles->x[nearest] + obstacles->w[nearest] / 2;
+    bool goLeft = threat > center;
+    // Don't dodge into a wall
+    if (goLeft && player->x < margin)
+      goLeft = false;
+    else if (!goLeft &&
+             player->x + player->width > state->screenWidth - margin)
+      goLeft = true;
+    return goLeft ? SIM_INPUT_LEFT : SIM_INPUT_RIGHT;
+  }
+
+  // Nothing above: go for a power-up, or back to the middle
+  float target = state->screenWidth / 2;
+  for (int i = 0; i < MAX_POWERUPS; i++) {
+    if (state->powerUps[i].active) {
+      const SimRect *rect = &state->powerUps[i].rect;
+      target = rect->x + rect->width / 2;
+      if (rect->y + rect->height < player->y)
+        input |= SIM_INPUT_UP;
+      break;
+    }
+  }
+  if (!(input & SIM_INPUT_UP) && player->y < 0.8f * state->screenHeight)
+    input |= SIM_INPUT_DOWN;
+  if (target < center - margin / 2)
+    input |= SIM_INPUT_LEFT;
+  else if (target > center + margin / 2)
+    input |= SIM_INPUT_RIGHT;
+  return input;
+}
+
+static const SimInput autopilotMoves[AUTOPILOT_MOVES] = {
+    0,
+    SIM_INPUT_LEFT,
+    SIM_INPUT_RIGHT,
+    SIM_INPUT_UP,
+    SIM_INPUT_DOWN,
+    SIM_INPUT_LEFT | SIM_INPUT_UP,
+    SIM_INPUT_LEFT | SIM_INPUT_DOWN,
+    SIM_INPUT_RIGHT | SIM_INPUT_UP,
+    SIM_INPUT_RIGHT | SIM_INPUT_DOWN,
+};
+
+static double Now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t NextRandom(uint64_t *rng) {
+  *rng ^= *rng << 13;
+  *rng ^= *rng >> 7;
+  *rng ^= *rng << 17;
+  return (uint32_t)(*rng >> 32);
+}
+
+bool AutopilotInit(Autopilot *pilot, uint64_t seed) {
+  memset(pilot, 0, sizeof(*pilot));
+  pilot->rng = seed * 0x9E3779B97F4A7C15ULL + 1;
+  return SimInit(&pilot->scratch, 800, 600, seed);
+}
+
+void AutopilotFree(Autopilot *pilot) {
+  SimFree(&pilot->scratch);
+  SimSnapshotFree(&pilot->root);
+}
+
+// Plays one rollout from the root snapshot and scores it. Returns false if
+// the root couldn't be restored (allocation failure).
+static bool Rollout(Autopilot *pilot, int firstMove, double *result) {
+  GameState *game = &pilot->scratch;
+  if (!SimSnapshotRestore(game, &pilot->root))
+    return false;
+
+  double score = 0;
+  SimInput input = autopilotMoves[firstMove];
+  for (int t = 0; t < AUTOPILOT_HORIZON; t++) {
+    if (t > 0 && t % AUTOPILOT_HOLD_TICKS == 0)
+      input = autopilotMoves[NextRandom(&pilot->rng) % AUTOPILOT_MOVES];
+    SimStep(game, input, SIM_DT);
+    if (game->gameOver) {
+      *result = score;
+      return true;
+    }
+    score += 1.0;
+    score += 30.0 * game->events[SIM_EVENT_POWERUP];
+  }
+
+  // Survivors: prefer ending up with room to dodge either way
+  float center = game->player.rect.x + game->player.rect.width / 2;
+  float offset = center / game->screenWidth - 0.5f;
+  *result = score - 10.0 * offset * offset;
+  return true;
+}
+
+SimInput AutopilotDecide(Autopilot *pilot, const GameState *state,
+                         double budgetMs) {
+  if (state->gameOver)
+    return SIM_INPUT_RESTART;
+  if (!SimSnapshotSave(state, &pilot->root))
+    return BotReflex(state);
+
+  memset(pilot->moveScore, 0, sizeof(pilot->moveScore));
+  memset(pilot->moveRollouts, 0, sizeof(pilot->moveRollouts));
+  double start = Now();
+  double deadline = start + budgetMs / 1000.0;
+  int rollouts = 0;
+  bool failed = false;
+
+  // Round-robin over the first moves so each gets a fair share of the
+  // budget, at least one full round. The rollouts' sim zones would swamp
+  // the real ones, keep them out of the profile.
+  PROFILE_BEGIN(PROFILE_AUTOPILOT);
+  PROFILE_SUSPEND();
+  do {
+    for (int move = 0; move < AUTOPILOT_MOVES; move++) {
+      double score;
+      if (!Rollout(pilot, move, &score)) {
+        failed = true;
+        break;
+      }
+      pilot->moveScore[move] += score;
+      pilot->moveRollouts[move]++;
+    }
+    rollouts += AUTOPILOT_MOVES;
+  } while (!failed && Now() < deadline);
+  PROFILE_RESUME();
+  PROFILE_END(PROFILE_AUTOPILOT);
+  // A rollout from stale scratch state would score garbage
+  if (failed)
+    return BotReflex(state);
+
+  double elapsed = Now() - start;
+  pilot->rollouts = rollouts;
+  pilot->rolloutsPerSecond = rollouts / (elapsed > 0 ? elapsed : 1e-9);
+
+  int best = 0;
+  for (int move = 1; move < AUTOPILOT_MOVES; move++) {
+    if (pilot->moveScore[move] / pilot->moveRollouts[move] >
+        pilot->moveScore[best] / pilot->moveRollouts[best])
+      best = move;
+  }
+  return autopilotMoves[best];
+}
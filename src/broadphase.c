@@ -0,0 +1,283 @@
+#include "broadphase.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t HashCell(int32_t cx, int32_t cy) {
+  return ((uint32_t)cx * 73856093u) ^ ((uint32_t)cy * 19349663u);
+}
+
+static bool Overlaps(float ax, float ay, float aw, float ah, float bx,
+                     float by, float bw, float bh) {
+  return ax < bx + bw && ax + aw > bx && ay < by + bh && ay + ah > by;
+}
+
+// floorf() without the libm call, this runs for every entity every tick
+static int32_t CellOf(const Broadphase *bp, float v) {
+  float scaled = v * bp->invCellSize;
+  int32_t cell = (int32_t)scaled;
+  return cell - (scaled < (float)cell);
+}
+
+static void Link(Broadphase *bp, int handle) {
+  int32_t *head = &bp->buckets[HashCell(bp->cellX[handle], bp->cellY[handle]) &
+                               bp->bucketMask];
+  bp->prev[handle] = -1;
+  bp->next[handle] = *head;
+  if (*head >= 0)
+    bp->prev[*head] = handle;
+  *head = handle;
+}
+
+static void Unlink(Broadphase *bp, int handle) {
+  int32_t next = bp->next[handle];
+  int32_t prev = bp->prev[handle];
+  if (prev >= 0)
+    bp->next[prev] = next;
+  else
+    bp->buckets[HashCell(bp->cellX[handle], bp->cellY[handle]) &
+                bp->bucketMask] = next;
+  if (next >= 0)
+    bp->prev[next] = prev;
+}
+
+// Grows the per-handle arrays and rehashes into twice as many buckets
+static bool Grow(Broadphase *bp, int capacity) {
+  size_t n = (size_t)capacity;
+  float *x = realloc(bp->x, n * sizeof(float));
+  if (x)
+    bp->x = x;
+  float *y = realloc(bp->y, n * sizeof(float));
+  if (y)
+    bp->y = y;
+  float *w = realloc(bp->w, n * sizeof(float));
+  if (w)
+    bp->w = w;
+  float *h = realloc(bp->h, n * sizeof(float));
+  if (h)
+    bp->h = h;
+  int32_t *cellX = realloc(bp->cellX, n * sizeof(int32_t));
+  if (cellX)
+    bp->cellX = cellX;
+  int32_t *cellY = realloc(bp->cellY, n * sizeof(int32_t));
+  if (cellY)
+    bp->cellY = cellY;
+  int32_t *next = realloc(bp->next, n * sizeof(int32_t));
+  if (next)
+    bp->next = next;
+  int32_t *prev = realloc(bp->prev, n * sizeof(int32_t));
+  if (prev)
+    bp->prev = prev;
+  bool *present = realloc(bp->present, n * sizeof(bool));
+  if (present)
+    bp->present = present;
+  if (!x || !y || !w || !h || !cellX || !cellY || !next || !prev || !present)
+    return false;
+  memset(bp->present + bp->capacity, 0, (n - bp->capacity) * sizeof(bool));
+  bp->capacity = capacity;
+
+  uint32_t bucketCount = 16;
+  while (bucketCount < 2u * (uint32_t)capacity)
+    bucketCount *= 2;
+  if (bucketCount - 1 != bp->bucketMask || !bp->buckets) {
+    int32_t *buckets = malloc(bucketCount * sizeof(int32_t));
+    if (!buckets)
+      return false;
+    free(bp->buckets);
+    bp->buckets = buckets;
+    bp->bucketMask = bucketCount - 1;
+    memset(bp->buckets, 0xFF, bucketCount * sizeof(int32_t));
+    for (int i = 0; i < bp->capacity; i++) {
+      if (bp->present[i])
+        Link(bp, i);
+    }
+  }
+  return true;
+}
+
+bool BroadphaseInit(Broadphase *bp, float cellSize, int capacity) {
+  memset(bp, 0, sizeof(*bp));
+  bp->cellSize = cellSize;
+  bp->invCellSize = 1.0f / cellSize;
+  if (!Grow(bp, capacity > 0 ? capacity : 16)) {
+    BroadphaseFree(bp);
+    return false;
+  }
+  return true;
+}
+
+void BroadphaseFree(Broadphase *bp) {
+  free(bp->x);
+  free(bp->y);
+  free(bp->w);
+  free(bp->h);
+  free(bp->cellX);
+  free(bp->cellY);
+  free(bp->next);
+  free(bp->prev);
+  free(bp->present);
+  free(bp->buckets);
+  memset(bp, 0, sizeof(*bp));
+}
+
+void BroadphaseClear(Broadphase *bp) {
+  memset(bp->present, 0, bp->capacity * sizeof(bool));
+  memset(bp->buckets, 0xFF, (bp->bucketMask + 1) * sizeof(int32_t));
+  bp->count = 0;
+  bp->maxWidth = 0.0f;
+  bp->maxHeight = 0.0f;
+}
+
+bool BroadphaseSet(Broadphase *bp, int handle, float x, float y, float w,
+                   float h) {
+  if (handle >= bp->capacity) {
+    int capacity = bp->capacity * 2;
+    if (capacity <= handle)
+      capacity = handle + 1;
+    if (!Grow(bp, capacity))
+      return false;
+  }
+
+  int32_t cx = CellOf(bp, x);
+  int32_t cy = CellOf(bp, y);
+  if (!bp->present[handle]) {
+    bp->present[handle] = true;
+    bp->count++;
+    bp->cellX[handle] = cx;
+    bp->cellY[handle] = cy;
+    Link(bp, handle);
+  } else if (cx != bp->cellX[handle] || cy != bp->cellY[handle]) {
+    Unlink(bp, handle);
+    bp->cellX[handle] = cx;
+    bp->cellY[handle] = cy;
+    Link(bp, handle);
+  }
+
+  bp->x[handle] = x;
+  bp->y[handle] = y;
+  bp->w[handle] = w;
+  bp->h[handle] = h;
+  if (w > bp->maxWidth)
+    bp->maxWidth = w;
+  if (h > bp->maxHeight)
+    bp->maxHeight = h;
+  return true;
+}
+
+bool BroadphaseSetMany(Broadphase *bp, int first, int n, const float *x,
+                       const float *y, const float *w, const float *h) {
+  if (first + n > bp->capacity && !Grow(bp, first + n))
+    return false;
+  for (int i = 0; i < n; i++) {
+    int handle = first + i;
+    // Fast path: still in the same cell, only the box changes
+    if (bp->present[handle] && bp->cellX[handle] == CellOf(bp, x[i]) &&
+        bp->cellY[handle] == CellOf(bp, y[i]) && w[i] <= bp->maxWidth &&
+        h[i] <= bp->maxHeight) {
+      bp->x[handle] = x[i];
+      bp->y[handle] = y[i];
+      bp->w[handle] = w[i];
+      bp->h[handle] = h[i];
+      continue;
+    }
+    BroadphaseSet(bp, handle, x[i], y[i], w[i], h[i]);
+  }
+  return true;
+}
+
+void BroadphaseRemove(Broadphase *bp, int handle) {
+  if (handle >= bp->capacity || !bp->present[handle])
+    return;
+  Unlink(bp, handle);
+  bp->present[handle] = false;
+  bp->count--;
+}
+
+// Calls back for every entity overlapping the box, in no particular order.
+// Stops when visit returns false.
+typedef bool (*VisitFn)(const Broadphase *bp, int handle, void *ctx);
+
+static void Visit(const Broadphase *bp, float x, float y, float w, float h,
+                  VisitFn visit, void *ctx) {
+  int32_t cx0 = CellOf(bp, x - bp->maxWidth);
+  int32_t cy0 = CellOf(bp, y - bp->maxHeight);
+  int32_t cx1 = CellOf(bp, x + w);
+  int32_t cy1 = CellOf(bp, y + h);
+
+  // A box covering more cells than there are buckets is cheaper to answer
+  // with a plain scan
+  int64_t cells = ((int64_t)cx1 - cx0 + 1) * ((int64_t)cy1 - cy0 + 1);
+  if (cells > (int64_t)bp->bucketMask + 1) {
+    for (int i = 0; i < bp->capacity; i++) {
+      if (bp->present[i] &&
+          Overlaps(x, y, w, h, bp->x[i], bp->y[i], bp->w[i], bp->h[i]) &&
+          !visit(bp, i, ctx))
+        return;
+    }
+    return;
+  }
+
+  for (int32_t cy = cy0; cy <= cy1; cy++) {
+    for (int32_t cx = cx0; cx <= cx1; cx++) {
+      int32_t i = bp->buckets[HashCell(cx, cy) & bp->bucketMask];
+      for (; i >= 0; i = bp->next[i]) {
+        // Other cells can share the bucket, skip them so nothing is
+        // reported twice
+        if (bp->cellX[i] != cx || bp->cellY[i] != cy)
+          continue;
+        if (Overlaps(x, y, w, h, bp->x[i], bp->y[i], bp->w[i], bp->h[i]) &&
+            !visit(bp, i, ctx))
+          return;
+      }
+    }
+  }
+}
+
+typedef struct {
+  int32_t *out;
+  int max;
+  int found;
+} QueryCtx;
+
+static bool CollectHandle(const Broadphase *bp, int handle, void *ctx) {
+  (void)bp;
+  QueryCtx *query = ctx;
+  query->out[query->found++] = handle;
+  return query->found < query->max;
+}
+
+int BroadphaseQuery(const Broadphase *bp, float x, float y, float w, float h,
+                    int32_t *out, int max) {
+  if (max <= 0 || bp->count == 0)
+    return 0;
+  QueryCtx query = {out, max, 0};
+  Visit(bp, x, y, w, h, CollectHandle, &query);
+  return query.found;
+}
+
+typedef struct {
+  BroadphasePair *out;
+  int max;
+  int found;
+  int32_t a;
+} PairCtx;
+
+static bool CollectPair(const Broadphase *bp, int handle, void *ctx) {
+  (void)bp;
+  PairCtx *pairs = ctx;
+  if (handle <= pairs->a)
+    return true;
+  pairs->out[pairs->found++] = (BroadphasePair){pairs->a, handle};
+  return pairs->found < pairs->max;
+}
+
+int BroadphasePairs(const Broadphase *bp, BroadphasePair *out, int max) {
+  PairCtx pairs = {out, max, 0, 0};
+  for (int a = 0; a < bp->capacity && pairs.found < max; a++) {
+    if (!bp->present[a])
+      continue;
+    pairs.a = a;
+    Visit(bp, bp->x[a], bp->y[a], bp->w[a], bp->h[a], CollectPair, &pairs);
+  }
+  return pairs.found;
+}
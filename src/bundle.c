@@ -0,0 +1,276 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bundle.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BUNDLE_MAGIC "RLBN"
+#define BUNDLE_VERSION 1
+#define BUNDLE_HEADER_SIZE 8
+#define BUNDLE_ENTRY_SIZE (BUNDLE_NAME_SIZE + 32)
+#define BUNDLE_MAX_ENTRIES 0xFFFF
+
+typedef struct {
+  BundleEntry entry;
+  uint8_t *copy;
+} PendingEntry;
+
+struct BundleWriter {
+  char path[512];
+  PendingEntry *entries;
+  int count;
+  int capacity;
+};
+
+static void PutLE(uint8_t *p, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++)
+    p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t GetLE(const uint8_t *p, int bytes) {
+  uint64_t v = 0;
+  for (int i = 0; i < bytes; i++)
+    v |= (uint64_t)p[i] << (8 * i);
+  return v;
+}
+
+// Byte-at-a-time CRC32 table, built by the preprocessor. Bundles are
+// verified at every startup, so the bitwise loop would cost more than the
+// decoding it replaces.
+#define CRC_BIT(c) (((c) >> 1) ^ (0xEDB88320u & (0u - ((c) & 1u))))
+#define CRC_BYTE(n)                                                            \
+  CRC_BIT(CRC_BIT(CRC_BIT(CRC_BIT(CRC_BIT(CRC_BIT(CRC_BIT(CRC_BIT(n))))))))
+#define CRC_ROW4(n)                                                            \
+  CRC_BYTE((n) + 0u), CRC_BYTE((n) + 1u), CRC_BYTE((n) + 2u),                  \
+      CRC_BYTE((n) + 3u)
+#define CRC_ROW16(n)                                                           \
+  CRC_ROW4(n), CRC_ROW4((n) + 4u), CRC_ROW4((n) + 8u), CRC_ROW4((n) + 12u)
+#define CRC_ROW64(n)                                                           \
+  CRC_ROW16(n), CRC_ROW16((n) + 16u), CRC_ROW16((n) + 32u),                    \
+      CRC_ROW16((n) + 48u)
+
+static const uint32_t crcTable[256] = {CRC_ROW64(0u), CRC_ROW64(64u),
+                                       CRC_ROW64(128u), CRC_ROW64(192u)};
+
+static uint32_t Crc32(const uint8_t *data, size_t size) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++)
+    crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static size_t AlignUp(size_t v) {
+  return (v + BUNDLE_ALIGN - 1) & ~(size_t)(BUNDLE_ALIGN - 1);
+}
+
+static bool MapFile(Bundle *bundle, const char *path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER size;
+  HANDLE mapping = NULL;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return false;
+  bundle->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  bundle->size = (size_t)size.QuadPart;
+  bundle->mapping = mapping;
+  if (!bundle->data) {
+    CloseHandle(mapping);
+    return false;
+  }
+  return true;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  void *data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+  bundle->data = data;
+  bundle->size = (size_t)st.st_size;
+  return true;
+#endif
+}
+
+bool BundleOpen(Bundle *bundle, const char *path) {
+  memset(bundle, 0, sizeof(*bundle));
+  if (!MapFile(bundle, path))
+    return false;
+
+  const uint8_t *p = bundle->data;
+  if (bundle->size < BUNDLE_HEADER_SIZE || memcmp(p, BUNDLE_MAGIC, 4) != 0 ||
+      GetLE(p + 4, 2) != BUNDLE_VERSION)
+    goto fail;
+  int count = (int)GetLE(p + 6, 2);
+  if (bundle->size < BUNDLE_HEADER_SIZE + (size_t)count * BUNDLE_ENTRY_SIZE)
+    goto fail;
+  bundle->entries = calloc(count ? count : 1, sizeof(BundleEntry));
+  if (!bundle->entries)
+    goto fail;
+
+  p += BUNDLE_HEADER_SIZE;
+  for (int i = 0; i < count; i++, p += BUNDLE_ENTRY_SIZE) {
+    BundleEntry *entry = &bundle->entries[i];
+    memcpy(entry->name, p, BUNDLE_NAME_SIZE);
+    entry->name[BUNDLE_NAME_SIZE - 1] = '\0';
+    const uint8_t *fields = p + BUNDLE_NAME_SIZE;
+    entry->type = (BundleType)GetLE(fields, 4);
+    uint64_t offset = GetLE(fields + 4, 4);
+    entry->size = (uint32_t)GetLE(fields + 8, 4);
+    entry->crc = (uint32_t)GetLE(fields + 12, 4);
+    for (int m = 0; m < 4; m++)
+      entry->meta[m] = (uint32_t)GetLE(fields + 16 + 4 * m, 4);
+    if (offset + entry->size > bundle->size)
+      goto fail;
+    entry->data = bundle->data + offset;
+  }
+  bundle->count = count;
+  return true;
+
+fail:
+  BundleClose(bundle);
+  return false;
+}
+
+void BundleClose(Bundle *bundle) {
+  if (bundle->data) {
+#ifdef _WIN32
+    UnmapViewOfFile(bundle->data);
+    CloseHandle(bundle->mapping);
+#else
+    munmap((void *)bundle->data, bundle->size);
+#endif
+  }
+  free(bundle->entries);
+  memset(bundle, 0, sizeof(*bundle));
+}
+
+const BundleEntry *BundleFind(const Bundle *bundle, const char *name) {
+  for (int i = 0; i < bundle->count; i++) {
+    if (strcmp(bundle->entries[i].name, name) == 0)
+      return &bundle->entries[i];
+  }
+  return NULL;
+}
+
+bool BundleVerify(const Bundle *bundle) {
+  for (int i = 0; i < bundle->count; i++) {
+    const BundleEntry *entry = &bundle->entries[i];
+    if (Crc32(entry->data, entry->size) != entry->crc)
+      return false;
+  }
+  return true;
+}
+
+BundleWriter *BundleWriterOpen(const char *path) {
+  BundleWriter *writer = calloc(1, sizeof(BundleWriter));
+  if (!writer)
+    return NULL;
+  snprintf(writer->path, sizeof(writer->path), "%s", path);
+  return writer;
+}
+
+bool BundleWriterAdd(BundleWriter *writer, const char *name, BundleType type,
+                     const uint32_t meta[4], const void *data, size_t size) {
+  if (strlen(name) >= BUNDLE_NAME_SIZE || size > UINT32_MAX ||
+      writer->count == BUNDLE_MAX_ENTRIES)
+    return false;
+  if (writer->count == writer->capacity) {
+    int capacity = writer->capacity ? writer->capacity * 2 : 16;
+    PendingEntry *entries =
+        realloc(writer->entries, (size_t)capacity * sizeof(PendingEntry));
+    if (!entries)
+      return false;
+    writer->entries = entries;
+    writer->capacity = capacity;
+  }
+  PendingEntry *pending = &writer->entries[writer->count];
+  memset(pending, 0, sizeof(*pending));
+  pending->copy = malloc(size ? size : 1);
+  if (!pending->copy)
+    return false;
+  memcpy(pending->copy, data, size);
+
+  BundleEntry *entry = &pending->entry;
+  snprintf(entry->name, sizeof(entry->name), "%s", name);
+  entry->type = type;
+  if (meta)
+    memcpy(entry->meta, meta, sizeof(entry->meta));
+  entry->size = (uint32_t)size;
+  entry->crc = Crc32(pending->copy, size);
+  writer->count++;
+  return true;
+}
+
+bool BundleWriterClose(BundleWriter *writer) {
+  FILE *file = fopen(writer->path, "wb");
+  bool ok = file != NULL;
+
+  if (ok) {
+    uint8_t header[BUNDLE_HEADER_SIZE];
+    memcpy(header, BUNDLE_MAGIC, 4);
+    PutLE(header + 4, BUNDLE_VERSION, 2);
+    PutLE(header + 6, (uint64_t)writer->count, 2);
+    ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+  }
+
+  // Offsets are known up front, data follows the index in order
+  size_t offset =
+      AlignUp(BUNDLE_HEADER_SIZE + (size_t)writer->count * BUNDLE_ENTRY_SIZE);
+  for (int i = 0; ok && i < writer->count; i++) {
+    const BundleEntry *entry = &writer->entries[i].entry;
+    if (offset + entry->size > UINT32_MAX) {
+      ok = false;
+      break;
+    }
+    uint8_t record[BUNDLE_ENTRY_SIZE] = {0};
+    memcpy(record, entry->name, BUNDLE_NAME_SIZE);
+    uint8_t *fields = record + BUNDLE_NAME_SIZE;
+    PutLE(fields, entry->type, 4);
+    PutLE(fields + 4, offset, 4);
+    PutLE(fields + 8, entry->size, 4);
+    PutLE(fields + 12, entry->crc, 4);
+    for (int m = 0; m < 4; m++)
+      PutLE(fields + 16 + 4 * m, entry->meta[m], 4);
+    ok = fwrite(record, 1, sizeof(record), file) == sizeof(record);
+    offset = AlignUp(offset + entry->size);
+  }
+
+  static const uint8_t padding[BUNDLE_ALIGN];
+  for (int i = 0; ok && i < writer->count; i++) {
+    long pos = ftell(file);
+    size_t pad = AlignUp((size_t)pos) - (size_t)pos;
+    const BundleEntry *entry = &writer->entries[i].entry;
+    ok = pos >= 0 && fwrite(padding, 1, pad, file) == pad &&
+         fwrite(writer->entries[i].copy, 1, entry->size, file) == entry->size;
+  }
+
+  if (file)
+    ok = fclose(file) == 0 && ok;
+  if (!ok)
+    remove(writer->path);
+  for (int i = 0; i < writer->count; i++)
+    free(writer->entries[i].copy);
+  free(writer->entries);
+  free(writer);
+  return ok;
+}
@@ -0,0 +1,324 @@
+#define _POSIX_C_SOURCE 200809L
+#include "highscore.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// On-disk record, little endian:
+//   "RLHS" | u16 version | u16 count | count * (i32 score, i64 timestamp)
+//   | u32 crc32 of everything before it
+// The original format (a raw native int) is still accepted on load.
+#define RECORD_MAGIC "RLHS"
+#define RECORD_VERSION 1
+#define RECORD_HEADER_SIZE 8
+#define RECORD_ENTRY_SIZE 12
+#define RECORD_MAX_SIZE                                                        \
+  (RECORD_HEADER_SIZE + LEADERBOARD_SIZE * RECORD_ENTRY_SIZE + 4)
+
+struct HighScoreStore {
+  char path[512];
+  char tmpPath[520];
+  float flushInterval;
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+
+  // Everything below is guarded by lock
+  ScoreEntry board[LEADERBOARD_SIZE];
+  int count;
+  int liveScore;
+  int64_t liveStarted;
+  bool dirty;
+  bool flushRequested;
+  bool quit;
+};
+
+static uint32_t Crc32(const uint8_t *data, size_t size) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+  }
+  return ~crc;
+}
+
+static void PutU16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void PutU32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void PutU64(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++)
+    p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint16_t GetU16(const uint8_t *p) { return p[0] | (uint16_t)p[1] << 8; }
+
+static uint32_t GetU32(const uint8_t *p) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++)
+    v |= (uint32_t)p[i] << (8 * i);
+  return v;
+}
+
+static uint64_t GetU64(const uint8_t *p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++)
+    v |= (uint64_t)p[i] << (8 * i);
+  return v;
+}
+
+// Inserts entry keeping the board sorted, best first
+static void InsertEntry(ScoreEntry *board, int *count, ScoreEntry entry) {
+  int pos = *count;
+  while (pos > 0 && board[pos - 1].score < entry.score)
+    pos--;
+  if (pos >= LEADERBOARD_SIZE)
+    return;
+  int last = *count < LEADERBOARD_SIZE ? *count : LEADERBOARD_SIZE - 1;
+  memmove(&board[pos + 1], &board[pos], (last - pos) * sizeof(ScoreEntry));
+  board[pos] = entry;
+  if (*count < LEADERBOARD_SIZE)
+    (*count)++;
+}
+
+static bool QualifiesFor(const ScoreEntry *board, int count, int score) {
+  return score > 0 &&
+         (count < LEADERBOARD_SIZE || score > board[count - 1].score);
+}
+
+static size_t EncodeRecord(uint8_t *buf, const ScoreEntry *board, int count) {
+  memcpy(buf, RECORD_MAGIC, 4);
+  PutU16(buf + 4, RECORD_VERSION);
+  PutU16(buf + 6, (uint16_t)count);
+  uint8_t *p = buf + RECORD_HEADER_SIZE;
+  for (int i = 0; i < count; i++, p += RECORD_ENTRY_SIZE) {
+    PutU32(p, (uint32_t)board[i].score);
+    PutU64(p + 4, (uint64_t)board[i].timestamp);
+  }
+  PutU32(p, Crc32(buf, p - buf));
+  return p + 4 - buf;
+}
+
+static int DecodeRecord(const uint8_t *buf, size_t size, ScoreEntry *board) {
+  if (size == sizeof(int)) {
+    // Legacy file: a single raw int
+    int legacy;
+    memcpy(&legacy, buf, sizeof(int));
+    if (legacy <= 0)
+      return 0;
+    board[0] = (ScoreEntry){legacy, 0};
+    return 1;
+  }
+
+  if (size < RECORD_HEADER_SIZE + 4 || memcmp(buf, RECORD_MAGIC, 4) != 0 ||
+      GetU16(buf + 4) != RECORD_VERSION)
+    return 0;
+  int count = GetU16(buf + 6);
+  size_t expected = RECORD_HEADER_SIZE + count * RECORD_ENTRY_SIZE + 4;
+  if (count > LEADERBOARD_SIZE || size != expected ||
+      GetU32(buf + expected - 4) != Crc32(buf, expected - 4))
+    return 0;
+
+  const uint8_t *p = buf + RECORD_HEADER_SIZE;
+  int loaded = 0;
+  for (int i = 0; i < count; i++, p += RECORD_ENTRY_SIZE) {
+    ScoreEntry entry = {(int32_t)GetU32(p), (int64_t)GetU64(p + 4)};
+    InsertEntry(board, &loaded, entry);
+  }
+  return loaded;
+}
+
+static int LoadRecord(const char *path, ScoreEntry *board) {
+  uint8_t buf[RECORD_MAX_SIZE];
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return 0;
+  size_t size = fread(buf, 1, sizeof(buf), file);
+  fclose(file);
+  return DecodeRecord(buf, size, board);
+}
+
+static bool WriteRecord(HighScoreStore *store, const uint8_t *buf,
+                        size_t size) {
+  FILE *file = fopen(store->tmpPath, "wb");
+  if (!file)
+    return false;
+  bool ok = fwrite(buf, 1, size, file) == size && fflush(file) == 0;
+  // Make sure the data is on disk before the rename makes it visible
+#ifdef _WIN32
+  ok = ok && _commit(_fileno(file)) == 0;
+#else
+  ok = ok && fsync(fileno(file)) == 0;
+#endif
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    remove(store->tmpPath);
+    return false;
+  }
+#ifdef _WIN32
+  return MoveFileExA(store->tmpPath, store->path,
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+  return rename(store->tmpPath, store->path) == 0;
+#endif
+}
+
+// Snapshots the board under the lock, then writes it with the lock released
+static void FlushLocked(HighScoreStore *store) {
+  ScoreEntry board[LEADERBOARD_SIZE];
+  int count = store->count;
+  memcpy(board, store->board, sizeof(board));
+  // A run in progress is written provisionally so a crash doesn't lose it
+  if (QualifiesFor(board, count, store->liveScore))
+    InsertEntry(board, &count,
+                (ScoreEntry){store->liveScore, store->liveStarted});
+  store->dirty = false;
+  store->flushRequested = false;
+
+  uint8_t buf[RECORD_MAX_SIZE];
+  size_t size = EncodeRecord(buf, board, count);
+
+  pthread_mutex_unlock(&store->lock);
+  if (!WriteRecord(store, buf, size))
+    fprintf(stderr, "Error saving %s\n", store->path);
+  pthread_mutex_lock(&store->lock);
+}
+
+static void *WriterThread(void *arg) {
+  HighScoreStore *store = arg;
+  pthread_mutex_lock(&store->lock);
+  while (!store->quit) {
+    if (!store->flushRequested) {
+      struct timespec deadline;
+      timespec_get(&deadline, TIME_UTC);
+      long long ns = deadline.tv_nsec + (long long)(store->flushInterval * 1e9);
+      deadline.tv_sec += ns / 1000000000;
+      deadline.tv_nsec = ns % 1000000000;
+      pthread_cond_timedwait(&store->wake, &store->lock, &deadline);
+    }
+    if (store->dirty)
+      FlushLocked(store);
+    store->flushRequested = false;
+  }
+  if (store->dirty)
+    FlushLocked(store);
+  pthread_mutex_unlock(&store->lock);
+  return NULL;
+}
+
+HighScoreStore *HighScoreOpen(const char *path, float flushInterval) {
+  HighScoreStore *store = calloc(1, sizeof(*store));
+  if (!store)
+    return NULL;
+  snprintf(store->path, sizeof(store->path), "%s", path);
+  snprintf(store->tmpPath, sizeof(store->tmpPath), "%s.tmp", path);
+  store->flushInterval = flushInterval > 0.0f ? flushInterval : 1.0f;
+  store->count = LoadRecord(path, store->board);
+
+  pthread_mutex_init(&store->lock, NULL);
+  pthread_cond_init(&store->wake, NULL);
+  if (pthread_create(&store->thread, NULL, WriterThread, store) != 0) {
+    pthread_cond_destroy(&store->wake);
+    pthread_mutex_destroy(&store->lock);
+    free(store);
+    return NULL;
+  }
+  return store;
+}
+
+void HighScoreClose(HighScoreStore *store) {
+  if (!store)
+    return;
+  pthread_mutex_lock(&store->lock);
+  if (QualifiesFor(store->board, store->count, store->liveScore)) {
+    InsertEntry(store->board, &store->count,
+                (ScoreEntry){store->liveScore, store->liveStarted});
+    store->dirty = true;
+  }
+  store->liveScore = 0;
+  store->quit = true;
+  pthread_cond_signal(&store->wake);
+  pthread_mutex_unlock(&store->lock);
+
+  pthread_join(store->thread, NULL);
+  pthread_cond_destroy(&store->wake);
+  pthread_mutex_destroy(&store->lock);
+  free(store);
+}
+
+int HighScoreBest(HighScoreStore *store) {
+  pthread_mutex_lock(&store->lock);
+  int best = store->count > 0 ? store->board[0].score : 0;
+  if (store->liveScore > best)
+    best = store->liveScore;
+  pthread_mutex_unlock(&store->lock);
+  return best;
+}
+
+void HighScoreSubmit(HighScoreStore *store, int score) {
+  pthread_mutex_lock(&store->lock);
+  if (store->liveScore == 0 && score > 0)
+    store->liveStarted = (int64_t)time(NULL);
+  if (score > store->liveScore &&
+      QualifiesFor(store->board, store->count, score))
+    store->dirty = true;
+  store->liveScore = score;
+  pthread_mutex_unlock(&store->lock);
+}
+
+void HighScoreRecordGame(HighScoreStore *store, int score) {
+  pthread_mutex_lock(&store->lock);
+  if (QualifiesFor(store->board, store->count, score)) {
+    int64_t started =
+        store->liveScore > 0 ? store->liveStarted : (int64_t)time(NULL);
+    InsertEntry(store->board, &store->count, (ScoreEntry){score, started});
+    store->dirty = true;
+  }
+  store->liveScore = 0;
+  store->flushRequested = true;
+  pthread_cond_signal(&store->wake);
+  pthread_mutex_unlock(&store->lock);
+}
+
+void HighScoreDiscardLive(HighScoreStore *store) {
+  pthread_mutex_lock(&store->lock);
+  // A flush may have written it provisionally, write the board without it
+  if (QualifiesFor(store->board, store->count, store->liveScore))
+    store->dirty = true;
+  store->liveScore = 0;
+  pthread_mutex_unlock(&store->lock);
+}
+
+void HighScoreFlush(HighScoreStore *store) {
+  pthread_mutex_lock(&store->lock);
+  store->flushRequested = true;
+  pthread_cond_signal(&store->wake);
+  pthread_mutex_unlock(&store->lock);
+}
+
+int HighScoreLeaderboard(HighScoreStore *store, ScoreEntry *out, int max) {
+  pthread_mutex_lock(&store->lock);
+  int n = store->count < max ? store->count : max;
+  memcpy(out, store->board, n * sizeof(ScoreEntry));
+  pthread_mutex_unlock(&store->lock);
+  return n;
+}
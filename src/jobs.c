@@ -0,0 +1,256 @@
+#define _POSIX_C_SOURCE 200809L
+#include "jobs.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// Splitting halves a range each time, so a deque never holds more than
+// about log2(count) ranges
+#define DEQUE_SIZE 128
+
+// A [begin, end) range packed into one word so deque slots can be atomic
+typedef uint64_t JobRange;
+
+static JobRange MakeRange(int begin, int end) {
+  return (uint64_t)(uint32_t)begin << 32 | (uint32_t)end;
+}
+static int RangeBegin(JobRange range) { return (int)(range >> 32); }
+static int RangeEnd(JobRange range) { return (int)(uint32_t)range; }
+
+// Chase-Lev deque: the owner pushes and pops at the bottom, thieves take
+// from the top
+typedef struct {
+  _Atomic int64_t top;
+  _Atomic int64_t bottom;
+  _Atomic JobRange slots[DEQUE_SIZE];
+  // Keep neighbouring deques off each other's cache lines
+  char pad[64];
+} JobDeque;
+
+typedef struct {
+  JobPool *pool;
+  int index;
+  pthread_t thread;
+} Worker;
+
+struct JobPool {
+  int workerCount;
+  JobDeque *deques;
+  Worker *workers;
+
+  // The job being run
+  JobFn fn;
+  void *ctx;
+  int grain;
+  _Atomic int remaining; // indices not yet processed
+  _Atomic int active;    // workers still inside the current job
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  uint64_t generation; // bumped for every JobPoolRun(), guarded by lock
+  bool quit;
+};
+
+static void Push(JobDeque *deque, JobRange range) {
+  int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  atomic_store_explicit(&deque->slots[b % DEQUE_SIZE], range,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+}
+
+static bool Pop(JobDeque *deque, JobRange *range) {
+  int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+  if (t > b) {
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return false;
+  }
+  *range = atomic_load_explicit(&deque->slots[b % DEQUE_SIZE],
+                                memory_order_relaxed);
+  if (t == b) {
+    // Last item, race the thieves for it
+    bool won = atomic_compare_exchange_strong_explicit(
+        &deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return won;
+  }
+  return true;
+}
+
+static bool Steal(JobDeque *deque, JobRange *range) {
+  int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+  if (t >= b)
+    return false;
+  *range = atomic_load_explicit(&deque->slots[t % DEQUE_SIZE],
+                                memory_order_relaxed);
+  return atomic_compare_exchange_strong_explicit(
+      &deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+static void Yield(void) {
+#ifdef _WIN32
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+// Works until every index of the current job has been processed
+static void WorkLoop(JobPool *pool, int self) {
+  JobDeque *own = &pool->deques[self];
+  uint32_t victim = (uint32_t)self * 2654435761u;
+
+  while (atomic_load_explicit(&pool->remaining, memory_order_acquire) > 0) {
+    JobRange range;
+    bool found = Pop(own, &range);
+    for (int i = 1; !found && i < pool->workerCount; i++) {
+      victim = victim * 1664525u + 1013904223u;
+      int other = (int)(victim % (uint32_t)pool->workerCount);
+      if (other != self)
+        found = Steal(&pool->deques[other], &range);
+    }
+    if (!found) {
+      Yield();
+      continue;
+    }
+
+    // Split big ranges, keeping the first half and exposing the rest
+    int begin = RangeBegin(range);
+    int end = RangeEnd(range);
+    while (end - begin > pool->grain) {
+      int mid = begin + (end - begin) / 2;
+      Push(own, MakeRange(mid, end));
+      end = mid;
+    }
+    pool->fn(pool->ctx, begin, end, self);
+    atomic_fetch_sub_explicit(&pool->remaining, end - begin,
+                              memory_order_release);
+  }
+}
+
+static void *WorkerThread(void *arg) {
+  Worker *worker = arg;
+  JobPool *pool = worker->pool;
+  uint64_t seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (pool->generation == seen && !pool->quit)
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    if (pool->quit)
+      break;
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    WorkLoop(pool, worker->index);
+    atomic_fetch_sub_explicit(&pool->active, 1, memory_order_release);
+
+    pthread_mutex_lock(&pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+JobPool *JobPoolCreate(int workers) {
+  if (workers < 1)
+    workers = 1;
+  JobPool *pool = calloc(1, sizeof(*pool));
+  if (!pool)
+    return NULL;
+  pool->workerCount = workers;
+  pool->deques = calloc(workers, sizeof(JobDeque));
+  pool->workers = calloc(workers, sizeof(Worker));
+  if (!pool->deques || !pool->workers) {
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+    return NULL;
+  }
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+
+  for (int i = 1; i < workers; i++) {
+    pool->workers[i] = (Worker){pool, i, 0};
+    if (pthread_create(&pool->workers[i].thread, NULL, WorkerThread,
+                       &pool->workers[i]) != 0) {
+      // Run with the threads we got
+      pool->workerCount = i;
+      break;
+    }
+  }
+  return pool;
+}
+
+void JobPoolDestroy(JobPool *pool) {
+  if (!pool)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for (int i = 1; i < pool->workerCount; i++)
+    pthread_join(pool->workers[i].thread, NULL);
+
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->deques);
+  free(pool->workers);
+  free(pool);
+}
+
+int JobPoolWorkers(const JobPool *pool) { return pool->workerCount; }
+
+void JobPoolRun(JobPool *pool, int count, int grain, JobFn fn, void *ctx) {
+  if (count <= 0)
+    return;
+  pool->fn = fn;
+  pool->ctx = ctx;
+  pool->grain = grain > 0 ? grain : 1;
+  atomic_store(&pool->remaining, count);
+  atomic_store(&pool->active, pool->workerCount - 1);
+
+  // Seed every deque with an equal share, stealing evens out the rest
+  int workers = pool->workerCount;
+  for (int i = 0; i < workers; i++) {
+    int begin = (int)((int64_t)count * i / workers);
+    int end = (int)((int64_t)count * (i + 1) / workers);
+    if (end > begin)
+      Push(&pool->deques[i], MakeRange(begin, end));
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->generation++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  WorkLoop(pool, 0);
+  // Nobody may still be touching fn/ctx when we return
+  while (atomic_load_explicit(&pool->active, memory_order_acquire) > 0)
+    Yield();
+}
+
+int JobHardwareThreads(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+#endif
+}
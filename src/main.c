@@ -1,391 +1,748 @@
+#include "assets.h"
+#include "audio.h"
+#include "bot.h"
+#include "highscore.h"
+#include "profiler.h"
 #include "raylib.h"
+#include "render.h"
+#include "replay.h"
+#include "rewind.h"
+#include "scene.h"
+#include "sim.h"
+#include "simthread.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-#define MAX_OBSTACLES 20
-#define INITIAL_OBSTACLES 2
-#define HIGHSCORE_FILE "highscore.dat"
-#define MAX_POWERUPS 5
+static RenderColor ToRenderColor(Color color) {
+  return (RenderColor){color.r, color.g, color.b, color.a};
+}
 
-typedef struct {
-  Rectangle rect;
-  Vector2 speed;
-  Color color;
-  bool active;
-} GameObject;
+static Color ToColor(RenderColor color) {
+  return (Color){color.r, color.g, color.b, color.a};
+}
 
-typedef struct {
-  Rectangle rect;
-  Texture2D texture;
-  bool active;
-  float timer;
-  float duration;
-  int type; // Ex -> 0: Invincibility
-} PowerUp;
+// raylib backend for the render list
+static void RaylibClear(void *context, RenderColor color) {
+  (void)context;
+  ClearBackground(ToColor(color));
+}
 
-typedef struct {
-  Vector2 position;
-  Color color;
-  float radius;
-  float alpha;
-  bool active;
-} FloorHitEffect;
-
-// spawn a new obstacle with relative positioning
-void SpawnObstacle(GameObject *obstacle, float screenWidth, float baseSpeed,
-                   float relativeX) {
-  obstacle->rect.x = relativeX * screenWidth;
-  obstacle->rect.y = -obstacle->rect.height;
-  obstacle->speed.y = baseSpeed + GetRandomValue(0, 200) / 100.0f;
-  obstacle->active = true;
-
-  Color colors[] = {RED, DARKGRAY, MAROON, ORANGE, DARKGREEN};
-  obstacle->color = colors[GetRandomValue(0, 4)];
+// rlgl merges consecutive draws that share a texture and a mode into one
+// draw call, the batches hand it exactly those runs
+static void RaylibBatch(void *context, const RenderList *list,
+                        const RenderCommand *commands, int count) {
+  (void)context;
+  switch (commands[0].primitive) {
+  case RENDER_RECT:
+    for (const RenderCommand *c = commands; c < commands + count; c++) {
+      DrawRectangleRec((Rectangle){c->x, c->y, c->width, c->height},
+                       ToColor(c->color));
+    }
+    break;
+  case RENDER_RECT_LINES:
+    for (const RenderCommand *c = commands; c < commands + count; c++) {
+      DrawRectangleLines((int)c->x, (int)c->y, (int)c->width, (int)c->height,
+                         ToColor(c->color));
+    }
+    break;
+  case RENDER_CIRCLE:
+    for (const RenderCommand *c = commands; c < commands + count; c++)
+      DrawCircleV((Vector2){c->x, c->y}, c->width, ToColor(c->color));
+    break;
+  case RENDER_TEXTURE: {
+    // DrawTexturePro() only reads the id and the size
+    Texture2D texture = {.id = commands[0].image.id,
+                         .width = commands[0].image.width,
+                         .height = commands[0].image.height,
+                         .mipmaps = 1,
+                         .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    for (const RenderCommand *c = commands; c < commands + count; c++) {
+      DrawTexturePro(texture,
+                     (Rectangle){c->sourceX, c->sourceY, c->sourceWidth,
+                                 c->sourceHeight},
+                     (Rectangle){c->x, c->y, c->width, c->height},
+                     (Vector2){0, 0}, 0.0f, ToColor(c->color));
+    }
+    break;
+  }
+  case RENDER_TEXT:
+    for (const RenderCommand *c = commands; c < commands + count; c++) {
+      DrawText(RenderCommandText(list, c), (int)c->x, (int)c->y,
+               (int)c->width, ToColor(c->color));
+    }
+    break;
+  }
+}
+
+#ifdef RAYLIBLEARN_PROFILER
+// p50/p99 per phase over the last PROFILER_HISTORY frames, the render list
+// counts of the last frame, and input latency and tick jitter
+static void DrawProfilerOverlay(RenderList *list, int screenWidth,
+                                SimTimingStats latency,
+                                SimTimingStats jitter) {
+  ProfileStats stats[PROFILE_ZONE_COUNT];
+  ProfileStats drawCalls;
+  int frames = ProfilerStats(stats, &drawCalls);
+  RenderStats last = list->stats;
+
+  int x = screenWidth - 260;
+  int y = 40;
+  RenderRect(list, RENDER_LAYER_OVERLAY, x - 10, y - 5, 260,
+             94 + PROFILE_ZONE_COUNT * 18,
+             ToRenderColor(Fade(BLACK, 0.7f)));
+  RenderText(list, RENDER_LAYER_OVERLAY,
+             TextFormat("%-10s %7s %7s  (%d)", "ms", "p50", "p99", frames), x,
+             y, 10, RENDER_WHITE);
+  for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+    y += 18;
+    RenderText(list, RENDER_LAYER_OVERLAY,
+               TextFormat("%-10s %7.3f %7.3f", ProfilerZoneName(zone),
+                          stats[zone].p50Ms, stats[zone].p99Ms),
+               x, y, 10, RENDER_WHITE);
+  }
+  RenderText(list, RENDER_LAYER_OVERLAY,
+             TextFormat("%-10s %7.0f %7.0f", "draws", drawCalls.p50Ms,
+                        drawCalls.p99Ms),
+             x, y + 18, 10, RENDER_WHITE);
+  RenderText(list, RENDER_LAYER_OVERLAY,
+             TextFormat("%-10s %7d batches (%d unsorted)", "", last.batches,
+                        last.unsortedBatches),
+             x, y + 36, 10, RENDER_WHITE);
+  RenderText(list, RENDER_LAYER_OVERLAY,
+             TextFormat("%-10s %7.3f %7.3f", "input lat", latency.p50Ms,
+                        latency.p99Ms),
+             x, y + 54, 10, RENDER_WHITE);
+  RenderText(list, RENDER_LAYER_OVERLAY,
+             TextFormat("%-10s %7.3f %7.3f", "tick jit", jitter.p50Ms,
+                        jitter.p99Ms),
+             x, y + 72, 10, RENDER_WHITE);
+}
+#endif
+
+// Samples the keyboard into a simulation input mask
+static SimInput PollInput(void) {
+  SimInput input = 0;
+  if (IsKeyDown(KEY_LEFT))
+    input |= SIM_INPUT_LEFT;
+  if (IsKeyDown(KEY_RIGHT))
+    input |= SIM_INPUT_RIGHT;
+  if (IsKeyDown(KEY_UP))
+    input |= SIM_INPUT_UP;
+  if (IsKeyDown(KEY_DOWN))
+    input |= SIM_INPUT_DOWN;
+  return input;
 }
 
-// spawn a new power-up
-void SpawnPowerUp(PowerUp *powerUp, float screenWidth, float screenHeight) {
-  powerUp->rect.width = 30;
-  powerUp->rect.height = 30;
-  powerUp->rect.x = GetRandomValue(50, screenWidth - 50 - powerUp->rect.width);
-  powerUp->rect.y =
-      GetRandomValue(50, screenHeight - 200 - powerUp->rect.height);
-  powerUp->active = true;
-  powerUp->timer = 0.0f;
-  powerUp->duration = 5.0f; // Example duration
-  powerUp->type = 0;        // Invincibility
+// The mixer's voices of each sound: the loaded sound and aliases of it,
+// which share its samples but play independently
+typedef struct {
+  Sound voices[SIM_EVENT_COUNT][AUDIO_MAX_VOICES];
+  int count[SIM_EVENT_COUNT];
+} SoundVoices;
+
+// A sound that failed to load, or whose aliases did, gets fewer voices
+static void SoundVoicesInit(SoundVoices *voices,
+                            const Sound sounds[SIM_EVENT_COUNT],
+                            AudioSoundConfig configs[SIM_EVENT_COUNT]) {
+  memset(voices, 0, sizeof(*voices));
+  for (int sound = 0; sound < SIM_EVENT_COUNT; sound++) {
+    configs[sound] = audioGameSounds[sound];
+    voices->voices[sound][0] = sounds[sound];
+    voices->count[sound] = 1;
+    if (sounds[sound].frameCount > 0) {
+      configs[sound].durationMs = 1000.0f * sounds[sound].frameCount /
+                                  sounds[sound].stream.sampleRate;
+      for (int i = 1; i < configs[sound].maxVoices; i++) {
+        Sound alias = LoadSoundAlias(sounds[sound]);
+        if (alias.stream.buffer == NULL)
+          break;
+        voices->voices[sound][voices->count[sound]++] = alias;
+      }
+    }
+    configs[sound].maxVoices = voices->count[sound];
+  }
 }
 
-int LoadHighScore() {
-  int highScore = 0;
-  FILE *file = fopen(HIGHSCORE_FILE, "rb");
-  if (file) {
-    fread(&highScore, sizeof(int), 1, file);
-    fclose(file);
+static void SoundVoicesFree(SoundVoices *voices) {
+  for (int sound = 0; sound < SIM_EVENT_COUNT; sound++) {
+    for (int i = 1; i < voices->count[sound]; i++)
+      UnloadSoundAlias(voices->voices[sound][i]);
   }
-  return highScore;
 }
 
-void SaveHighScore(int score) {
-  FILE *file = fopen(HIGHSCORE_FILE, "wb");
-  if (file) {
-    fwrite(&score, sizeof(int), 1, file);
-    fclose(file);
+static void SoundVoicePlay(void *context, int sound, int voice) {
+  PlaySound(((SoundVoices *)context)->voices[sound][voice]);
+}
+
+static void SoundVoiceStop(void *context, int sound, int voice) {
+  StopSound(((SoundVoices *)context)->voices[sound][voice]);
+}
+
+// Sounds and the leaderboard for a tick's events, or for every tick since
+// the last frame in threaded mode
+static void HandleEvents(const int events[SIM_EVENT_COUNT], int score,
+                         bool assisted, AudioMixer *mixer,
+                         HighScoreStore *scores, ScoreEntry *leaderboard,
+                         int *leaderboardCount) {
+  for (int event = 0; event < SIM_EVENT_COUNT; event++) {
+    // Dropped if the mixer is behind, a missed sound is better than a
+    // stalled frame
+    if (events[event] && mixer)
+      AudioPost(mixer, event, events[event]);
+  }
+  if (events[SIM_EVENT_COLLISION]) {
+    // Written in the background, the frame never waits on the disk
+    if (!assisted)
+      HighScoreRecordGame(scores, score);
+    *leaderboardCount =
+        HighScoreLeaderboard(scores, leaderboard, LEADERBOARD_SIZE);
   }
 }
 
-int main(void) {
-  int screenWidth = 800;
-  int screenHeight = 600;
-  SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+// Time the autopilot may spend searching per frame
+#define AUTOPILOT_BUDGET_MS 4.0
+
+// Holding Backspace goes back this far, this many ticks per frame. A swarm
+// writes about 2 MB of history per second, classic mode a few KB.
+#define REWIND_SECONDS 10
+#define REWIND_STEPS_PER_FRAME 2
+#define REWIND_BUDGET_MB 32
+
+// usage: raylibLearn [--swarm [obstacles]] [--record file | --replay file]
+//                    [--autopilot] [--threaded]
+int main(int argc, char **argv) {
+  int swarmObstacles = 0;
+  bool autopilot = false;
+  bool threaded = false;
+  const char *recordPath = NULL;
+  const char *replayPath = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--swarm") == 0) {
+      swarmObstacles = SIM_SWARM_OBSTACLES;
+      if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+        swarmObstacles = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (strcmp(argv[i], "--autopilot") == 0) {
+      autopilot = true;
+    } else if (strcmp(argv[i], "--threaded") == 0) {
+      threaded = true;
+    }
+  }
+  // Replays are stepped and recorded tick by tick on this thread
+  if (threaded && (recordPath || replayPath)) {
+    printf("--threaded is ignored with --record and --replay\n");
+    threaded = false;
+  }
+
+  // Failures after this point go to the cleanup at the end of main, which
+  // undoes what was set up before them in reverse order
+  int status = 1;
+
+  // A replay brings its own seed, mode and screen size
+  ReplayReader replay;
+  bool replaying = replayPath != NULL;
+  bool replayDone = false;
+  bool replayMatched = false;
+  ReplayHeader header = {(uint64_t)time(NULL), 800, 600, swarmObstacles};
+  if (replaying) {
+    if (!ReplayReaderOpen(&replay, replayPath)) {
+      printf("Error opening replay %s\n", replayPath);
+      return 1;
+    }
+    header = replay.header;
+  }
+
+  // Assets load on a background thread while the window and the game are
+  // set up. The bundle sits next to the executable, loose files are
+  // looked up from the working directory.
+  AssetLoader *assets =
+      AssetsLoadAsync(TextFormat("%s%s", GetApplicationDirectory(),
+                                 RESOURCE_BUNDLE),
+                      RESOURCE_DIR, gameAssetNames, ASSET_COUNT);
+  if (!assets) {
+    printf("Error starting the asset loader\n");
+    goto closeReplay;
+  }
+
+  int screenWidth = header.screenWidth;
+  int screenHeight = header.screenHeight;
+  // Resizing changes the simulation, so recordings, replays and the sim
+  // thread keep the window size fixed
+  if (!replaying && !recordPath && !threaded)
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
   InitWindow(screenWidth, screenHeight, "Dynamic Dodge Game");
   SetWindowMinSize(400, 300); // sets minimum window size
-  SetRandomSeed(time(NULL));
   InitAudioDevice();
 
-  // sounds
-  Sound collisionSound = LoadSound("resources/collision.wav");
-  if (collisionSound.frameCount == 0)
-    printf("Error loading collision.wav\n");
-  Sound powerUpSound = LoadSound("resources/powerup.wav");
-  if (powerUpSound.frameCount == 0)
-    printf("Error loading powerup.wav\n");
-  Sound floorHitSound = LoadSound("resources/floorhit.wav");
-  if (floorHitSound.frameCount == 0)
-    printf("Error loading floorhit.wav\n");
-
-  GameObject player = {
-      .rect = {0.5f * screenWidth - 15, 0.8f * screenHeight, 30, 30},
-      .speed = {5.0f, 5.0f},
-      .color = BLUE,
-      .active = true};
-
-  // obstacle array
-  GameObject obstacles[MAX_OBSTACLES];
-  for (int i = 0; i < MAX_OBSTACLES; i++) {
-    obstacles[i].rect = (Rectangle){0, 0, 30, 30};
-    obstacles[i].active = false;
+  // Draws are recorded into the list every frame, then sorted and batched
+  RenderList renderList;
+  if (!RenderListInit(&renderList)) {
+    printf("Error allocating the render list\n");
+    goto closeWindow;
   }
+  RenderBackend renderer = {NULL, RaylibClear, RaylibBatch};
+  SceneHud hud = {0};
 
-  // Initializes power-up array
-  PowerUp powerUps[MAX_POWERUPS];
-  Texture2D invincibilityTexture = LoadTexture("resources/star.png");
-  if (invincibilityTexture.id == 0)
-    printf("Error loading star.png\n");
-  for (int i = 0; i < MAX_POWERUPS; i++) {
-    powerUps[i].rect = (Rectangle){0, 0, 30, 30};
-    powerUps[i].active = false;
-    powerUps[i].texture = invincibilityTexture;
+  GameState game;
+  if (!ReplayInitGame(&header, &game)) {
+    printf("Error allocating the game state\n");
+    goto freeRenderList;
   }
 
-  // Initializes floor hit effects
-  FloorHitEffect floorHits[MAX_OBSTACLES];
-  for (int i = 0; i < MAX_OBSTACLES; i++) {
-    floorHits[i].active = false;
+  ReplayWriter *recorder = NULL;
+  if (recordPath) {
+    recorder = ReplayWriterOpen(recordPath, &header);
+    if (!recorder)
+      printf("Error creating replay %s\n", recordPath);
   }
 
-  int score = 0;
-  int highScore = LoadHighScore();
-  int activeObstacles = INITIAL_OBSTACLES;
-  float baseSpeed = 3.0f;
-  bool gameOver = false;
+  HighScoreStore *scores =
+      HighScoreOpen(HIGHSCORE_FILE, HIGHSCORE_FLUSH_INTERVAL);
+  if (!scores) {
+    printf("Error starting the high score writer\n");
+    goto closeRecorder;
+  }
+  int highScore = HighScoreBest(scores);
+  ScoreEntry leaderboard[LEADERBOARD_SIZE];
+  int leaderboardCount =
+      HighScoreLeaderboard(scores, leaderboard, LEADERBOARD_SIZE);
   bool gamePaused = false;
-  float timePlayed = 0.0f;
-  int nextObstacleScore = 500;
-  bool isInvincible = false;
-  float invincibilityTimer = 0.0f;
-  float invincibilityDuration = 5.0f;
-  float powerUpSpawnTimer = 0.0f;
-  float powerUpSpawnInterval = 10.0f;
-
-  for (int i = 0; i < INITIAL_OBSTACLES; i++) {
-    float relativeX = GetRandomValue(0, 100) / 100.0f;
-    SpawnObstacle(&obstacles[i], screenWidth, baseSpeed, relativeX);
+  float accumulator = 0.0f;
+  // Key presses are latched until a tick consumes them, a frame may run
+  // zero ticks
+  SimInput pendingInput = 0;
+
+  // Attract mode: the autopilot plays, toggled with A. Assisted runs and
+  // replays stay off the leaderboard.
+  Autopilot pilot;
+  if (!AutopilotInit(&pilot, header.seed)) {
+    printf("Error allocating the autopilot\n");
+    goto closeScores;
   }
+  bool assisted = autopilot || replaying;
+
+  // Rewinding keeps recordings and replays from lining up with their
+  // inputs, so it's only there in free play on this thread. Rewound runs
+  // count as assisted.
+  RewindBuffer rewind;
+  bool rewindEnabled = !replaying && !recordPath && !threaded;
+  if (rewindEnabled &&
+      !RewindInit(&rewind, (size_t)REWIND_BUDGET_MB * 1024 * 1024,
+                  REWIND_KEYFRAME_INTERVAL)) {
+    printf("Error allocating the rewind history\n");
+    goto freePilot;
+  }
+  bool rewinding = false;
+  uint64_t rewindStep = 0;
+
+  // Threaded mode: the sim thread owns game, frames draw between the two
+  // newest ticks it published. shown is the state drawn in either mode.
+  SimThread *simThread = NULL;
+  GameState views[2];
+  GameState *previousView = &views[0];
+  GameState *shown = &game;
+  SimFrameInfo previousInfo = {0};
+  SimFrameInfo currentInfo = {0};
+  int framesTaken = 0;
+  SimInput sentInput = 0;
+  if (threaded) {
+    if (!ReplayInitGame(&header, &views[0])) {
+      printf("Error allocating the game state\n");
+      goto freeRewind;
+    }
+    if (!ReplayInitGame(&header, &views[1])) {
+      printf("Error allocating the game state\n");
+      SimFree(&views[0]);
+      goto freeRewind;
+    }
+    shown = &views[1];
+  }
+
+  // Input latency runs from sampling a change to the end of the first
+  // frame showing a tick that used it, jitter is how far tick intervals
+  // stray from SIM_DT. Measured in both modes, shown in the F1 overlay.
+  SimTiming inputLatency = {0};
+  SimTiming tickJitter = {0};
+  SimInput lastFrameInput = 0;
+  uint64_t changedNs = 0;  // not yet stepped
+  uint64_t consumedNs = 0; // stepped, not yet shown
+  uint64_t shownInputNs = 0;
+  uint64_t lastTickNs = 0;
+#ifdef RAYLIBLEARN_PROFILER
+  bool showProfiler = false;
+#endif
 
   SetTargetFPS(60);
 
+  // Loading screen until the asset thread is done
+  while (!AssetsReady(assets) && !WindowShouldClose()) {
+    int x = GetScreenWidth() / 2 - 100;
+    int y = GetScreenHeight() / 2;
+    RenderBegin(&renderList, RENDER_RAYWHITE);
+    RenderText(&renderList, RENDER_LAYER_HUD, "Loading...", x, y - 30, 20,
+               RENDER_DARKGRAY);
+    RenderRect(&renderList, RENDER_LAYER_HUD, x, y,
+               (int)(200 * AssetsProgress(assets)), 10, RENDER_BLUE);
+    RenderRectLines(&renderList, RENDER_LAYER_HUD, x, y, 200, 10,
+                    RENDER_DARKGRAY);
+    BeginDrawing();
+    RenderFlush(&renderList, &renderer);
+    EndDrawing();
+  }
+  AssetsWait(assets);
+
+  // sounds
+  Sound collisionSound = AssetsSound(assets, ASSET_COLLISION_SOUND);
+  if (collisionSound.frameCount == 0)
+    printf("Error loading collision.wav\n");
+  Sound powerUpSound = AssetsSound(assets, ASSET_POWERUP_SOUND);
+  if (powerUpSound.frameCount == 0)
+    printf("Error loading powerup.wav\n");
+  Sound floorHitSound = AssetsSound(assets, ASSET_FLOOR_HIT_SOUND);
+  if (floorHitSound.frameCount == 0)
+    printf("Error loading floorhit.wav\n");
+  const Sound eventSounds[SIM_EVENT_COUNT] = {
+      [SIM_EVENT_FLOOR_HIT] = floorHitSound,
+      [SIM_EVENT_POWERUP] = powerUpSound,
+      [SIM_EVENT_COLLISION] = collisionSound};
+  // Swarm mode lands dozens of obstacles a second, the mixer merges and
+  // limits their sounds
+  SoundVoices soundVoices;
+  AudioSoundConfig soundConfigs[SIM_EVENT_COUNT];
+  SoundVoicesInit(&soundVoices, eventSounds, soundConfigs);
+  AudioMixer *mixer = AudioMixerOpen(
+      soundConfigs, SIM_EVENT_COUNT, AUDIO_GAME_VOICES,
+      (AudioBackend){&soundVoices, SoundVoicePlay, SoundVoiceStop});
+  if (!mixer)
+    printf("Error starting the audio mixer, playing without sound\n");
+
+  Texture2D invincibilityTexture = AssetsTexture(assets, ASSET_STAR_TEXTURE);
+  if (invincibilityTexture.id == 0)
+    printf("Error loading star.png\n");
+  RenderImage invincibilityImage = {invincibilityTexture.id,
+                                    (uint16_t)invincibilityTexture.width,
+                                    (uint16_t)invincibilityTexture.height};
+
+  printf("Assets loaded in %.1f ms from %s\n", AssetsLoadMs(assets),
+         AssetsFromBundle(assets) ? RESOURCE_BUNDLE : "loose files");
+  // The audio device and the GPU have their own copies now
+  AssetsClose(assets);
+  assets = NULL;
+
+  if (threaded) {
+    simThread = SimThreadStart(&game);
+    if (!simThread) {
+      printf("Error starting the sim thread, stepping on this one\n");
+      SimFree(&views[0]);
+      SimFree(&views[1]);
+      threaded = false;
+      shown = &game;
+    }
+  }
+
   while (!WindowShouldClose()) {
     float deltaTime = GetFrameTime();
+    if (deltaTime > SIM_MAX_FRAME_TIME)
+      deltaTime = SIM_MAX_FRAME_TIME;
+    uint64_t frameStartNs = ProfilerNow();
 
-    if (IsWindowResized()) {
+    if (IsWindowResized() && !simThread) {
       screenWidth = GetScreenWidth();
       screenHeight = GetScreenHeight();
-      // Adjust player position relative to new screen size
-      player.rect.y = 0.8f * screenHeight;
+      SimResize(&game, screenWidth, screenHeight);
+      // Older states have the old screen size
+      if (rewindEnabled)
+        RewindClear(&rewind);
     }
 
     if (IsKeyPressed(KEY_SPACE))
       gamePaused = !gamePaused;
+    if (IsKeyPressed(KEY_R))
+      pendingInput |= SIM_INPUT_RESTART;
+    if (IsKeyPressed(KEY_A) && !replaying) {
+      autopilot = !autopilot;
+      if (autopilot && !assisted)
+        HighScoreDiscardLive(scores);
+      assisted = assisted || autopilot;
+    }
+#ifdef RAYLIBLEARN_PROFILER
+    // F1 toggles the overlay, F2 dumps the history
+    if (IsKeyPressed(KEY_F1))
+      showProfiler = !showProfiler;
+    if (IsKeyPressed(KEY_F2) && ProfilerExportCsv("profile.csv") &&
+        ProfilerExportTrace("profile.json"))
+      printf("Wrote profile.csv and profile.json\n");
+#endif
+
+    // One search per frame, its move is held for the frame's ticks
+    SimInput pilotInput = 0;
+    if (autopilot && !replaying && !(gamePaused && !shown->gameOver))
+      pilotInput = AutopilotDecide(&pilot, shown, AUTOPILOT_BUDGET_MS);
+    SimInput frameInput = autopilot ? pilotInput : PollInput() | pendingInput;
+    if (frameInput != lastFrameInput) {
+      changedNs = frameStartNs;
+      lastFrameInput = frameInput;
+    }
 
-    if (!gameOver && !gamePaused) {
-      // Update time and score
-      timePlayed += deltaTime;
-      score = (int)(timePlayed * 100);
-
-      // Update high score
-      if (score > highScore) {
-        highScore = score;
-        SaveHighScore(highScore);
+    PROFILE_BEGIN(PROFILE_SIM);
+    if (simThread) {
+      // Only changes go to the sim thread, stamped with the frame start
+      if (frameInput != sentInput &&
+          SimThreadPush(simThread, frameInput, frameStartNs)) {
+        sentInput = frameInput;
+        pendingInput = 0;
       }
-
-      // Increase the difficulty based on score
-      baseSpeed = 3.0f + (score / 1000.0f);
-
-      // Add a new obstacle when score threshold is reached
-      if (score >= nextObstacleScore && activeObstacles < MAX_OBSTACLES) {
-        activeObstacles++;
-        nextObstacleScore += 500;
-        for (int i = 0; i < MAX_OBSTACLES; i++) {
-          if (!obstacles[i].active) {
-            float relativeX = GetRandomValue(0, 100) / 100.0f;
-            SpawnObstacle(&obstacles[i], screenWidth, baseSpeed, relativeX);
-            break;
-          }
+      SimThreadPause(simThread, gamePaused);
+
+      SimFrameInfo info;
+      if (SimThreadAcquire(simThread, previousView, &info)) {
+        GameState *newest = previousView;
+        previousView = shown;
+        shown = newest;
+        previousInfo = currentInfo;
+        currentInfo = info;
+        framesTaken++;
+        // The sim thread ignores a restart mid-run, only one it honoured
+        // starts an unassisted run
+        if (previousView->gameOver && !shown->gameOver) {
+          gamePaused = false;
+          assisted = autopilot || replaying;
         }
+        HandleEvents(info.events, shown->score, assisted, mixer, scores,
+                     leaderboard, &leaderboardCount);
       }
+    } else if (rewindEnabled && IsKeyDown(KEY_BACKSPACE) &&
+        RewindHas(&rewind, rewind.newestStep)) {
+      uint64_t limit = rewind.oldestStep;
+      if (rewind.newestStep - limit > REWIND_SECONDS * SIM_TICK_RATE)
+        limit = rewind.newestStep - REWIND_SECONDS * SIM_TICK_RATE;
+      if (!rewinding)
+        rewindStep = rewind.newestStep;
+      rewindStep = rewindStep > limit + REWIND_STEPS_PER_FRAME
+                       ? rewindStep - REWIND_STEPS_PER_FRAME
+                       : limit;
+      rewinding = RewindSeek(&rewind, rewindStep, &game);
+      if (!assisted)
+        HighScoreDiscardLive(scores);
+      assisted = true;
+    } else if (rewinding) {
+      // Play goes on from the rewound tick
+      RewindTruncate(&rewind, rewindStep);
+      rewinding = false;
+    }
 
-      // Power-up the spawning
-      powerUpSpawnTimer += deltaTime;
-      if (powerUpSpawnTimer >= powerUpSpawnInterval) {
-        powerUpSpawnTimer = 0.0f;
-        for (int i = 0; i < MAX_POWERUPS; i++) {
-          if (!powerUps[i].active) {
-            SpawnPowerUp(&powerUps[i], screenWidth, screenHeight);
-            break;
-          }
+    if (simThread) {
+      // Stepped on its own thread
+    } else if ((gamePaused && !game.gameOver) || rewinding) {
+      accumulator = 0.0f;
+      lastTickNs = 0;
+    } else {
+      accumulator += deltaTime;
+      while (accumulator >= SIM_DT && !replayDone) {
+        SimInput input = autopilot ? pilotInput : PollInput() | pendingInput;
+        if (replaying && !ReplayReaderNext(&replay, &input)) {
+          replayDone = true;
+          replayMatched = replay.hasEnd && replay.endSteps == replay.steps &&
+                          replay.endHash == SimHash(&game);
+          break;
         }
-      }
-
-      float moveSpeed = player.speed.x * (screenWidth / 800.0f);
-      if (IsKeyDown(KEY_RIGHT) &&
-          (player.rect.x + player.rect.width) < screenWidth)
-        player.rect.x += moveSpeed;
-      if (IsKeyDown(KEY_LEFT) && player.rect.x > 0)
-        player.rect.x -= moveSpeed;
-      if (IsKeyDown(KEY_UP) && player.rect.y > 0)
-        player.rect.y -= moveSpeed;
-      if (IsKeyDown(KEY_DOWN) &&
-          (player.rect.y + player.rect.height) < screenHeight)
-        player.rect.y += moveSpeed;
-
-      // Update power-ups
-      for (int i = 0; i < MAX_POWERUPS; i++) {
-        if (powerUps[i].active) {
-          if (CheckCollisionRecs(player.rect, powerUps[i].rect)) {
-            PlaySound(powerUpSound);
-            powerUps[i].active = false;
-            isInvincible = true;
-            invincibilityTimer = 0.0f;
-          }
+        bool wasOver = game.gameOver;
+        SimStep(&game, input, SIM_DT);
+        SimTimingAddTick(&tickJitter, &lastTickNs, ProfilerNow());
+        if (changedNs) {
+          consumedNs = changedNs;
+          changedNs = 0;
         }
-      }
-
-      // Handling invincibility
-      if (isInvincible) {
-        invincibilityTimer += deltaTime;
-        if (invincibilityTimer >= invincibilityDuration) {
-          isInvincible = false;
+        if (rewindEnabled)
+          RewindAppend(&rewind, &game);
+        if (recorder)
+          ReplayWriterAppend(recorder, input);
+        accumulator -= SIM_DT;
+        // A restart only counts once the sim honours it, mid-run it is
+        // ignored and the run stays assisted
+        if (wasOver && !game.gameOver) {
+          gamePaused = false;
+          assisted = autopilot || replaying;
         }
-      }
+        pendingInput = 0;
+        // A restart is only needed once
+        pilotInput &= ~SIM_INPUT_RESTART;
 
-      // Updating the obstacles and handling the collisions
-      for (int i = 0; i < MAX_OBSTACLES; i++) {
-        if (obstacles[i].active) {
-          obstacles[i].rect.y += obstacles[i].speed.y;
-
-          if (obstacles[i].rect.y > screenHeight) {
-            // floor hit effect triggered
-            for (int j = 0; j < MAX_OBSTACLES; j++) {
-              if (!floorHits[j].active) {
-                floorHits[j].active = true;
-                floorHits[j].position =
-                    (Vector2){obstacles[i].rect.x + obstacles[i].rect.width / 2,
-                              screenHeight};
-                floorHits[j].color = obstacles[i].color;
-                floorHits[j].radius = 10.0f;
-                floorHits[j].alpha = 1.0f;
-                PlaySound(floorHitSound);
-                break;
-              }
-            }
-            float relativeX = GetRandomValue(0, 100) / 100.0f;
-            SpawnObstacle(&obstacles[i], screenWidth, baseSpeed, relativeX);
-          }
-
-          if (!isInvincible &&
-              CheckCollisionRecs(player.rect, obstacles[i].rect)) {
-            gameOver = true;
-            PlaySound(collisionSound);
-            break;
-          }
-        }
-      }
-
-      // Updates the floor hit effects
-      for (int i = 0; i < MAX_OBSTACLES; i++) {
-        if (floorHits[i].active) {
-          floorHits[i].radius += 5.0f;
-          floorHits[i].alpha -= 0.05f;
-          if (floorHits[i].alpha <= 0.0f) {
-            floorHits[i].active = false;
-          }
-        }
+        HandleEvents(game.events, game.score, assisted, mixer, scores,
+                     leaderboard, &leaderboardCount);
       }
     }
 
-    BeginDrawing();
-    {
-      ClearBackground(RAYWHITE);
-
-      if (!gameOver) {
-        // Drawing the player (with invincibility color)
-        DrawRectangleRec(player.rect, isInvincible ? YELLOW : player.color);
+    PROFILE_END(PROFILE_SIM);
 
-        // Drawing obstacles
-        for (int i = 0; i < MAX_OBSTACLES; i++) {
-          if (obstacles[i].active) {
-            DrawRectangleRec(obstacles[i].rect, obstacles[i].color);
-          }
-        }
+    // Update high score, replays and autopilot runs don't count
+    if (!shown->gameOver && !assisted)
+      HighScoreSubmit(scores, shown->score);
+    highScore = HighScoreBest(scores);
 
-        // Drawing power-ups
-        for (int i = 0; i < MAX_POWERUPS; i++) {
-          if (powerUps[i].active) {
-            DrawTexturePro(powerUps[i].texture,
-                           (Rectangle){0, 0, powerUps[i].texture.width,
-                                       powerUps[i].texture.height},
-                           powerUps[i].rect, (Vector2){0, 0}, 0.0f, WHITE);
-          }
-        }
-
-        // Drawing floor hit effects
-        for (int i = 0; i < MAX_OBSTACLES; i++) {
-          if (floorHits[i].active) {
-            DrawCircleV(floorHits[i].position, floorHits[i].radius,
-                        Fade(floorHits[i].color, floorHits[i].alpha));
-          }
-        }
-
-        // Draw HUD
-        DrawText(TextFormat("Score: %d", score), 10, 10, 20, BLACK);
-        DrawText(TextFormat("High Score: %d", highScore), 10, 40, 20, BLACK);
-        DrawText(TextFormat("Speed: %.1f", baseSpeed), 10, 70, 20, BLACK);
-        DrawText(TextFormat("Obstacles: %d", activeObstacles), 10, 100, 20,
-                 BLACK);
-        if (isInvincible) {
-          DrawText(TextFormat("Invincible: %.1f",
-                              invincibilityDuration - invincibilityTimer),
-                   10, 130, 20, GOLD);
-        }
+    // Threaded mode draws a tick behind the sim thread, the way from the
+    // previous to the newest tick that time has come
+    float alpha = 1.0f;
+    if (framesTaken > 1 && currentInfo.tickNs > previousInfo.tickNs) {
+      alpha = (float)((double)(frameStartNs - currentInfo.tickNs) /
+                      (double)(currentInfo.tickNs - previousInfo.tickNs));
+      alpha = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+    }
 
+    BeginDrawing();
+    {
+      PROFILE_ZONE(PROFILE_DRAW);
+      RenderBegin(&renderList, RENDER_RAYWHITE);
+      // Effects, the world and the HUD
+      SceneRecordInterpolated(&renderList, &hud,
+                              framesTaken > 1 ? previousView : NULL, shown,
+                              alpha, highScore, invincibilityImage);
+
+      if (!shown->gameOver) {
         // Drawing pause message
         if (gamePaused) {
-          DrawText("PAUSED", screenWidth / 2 - 60, screenHeight / 2, 40, GRAY);
-          DrawText("Press SPACE to continue", screenWidth / 2 - 120,
-                   screenHeight / 2 + 50, 20, DARKGRAY);
+          RenderText(&renderList, RENDER_LAYER_HUD, "PAUSED",
+                     screenWidth / 2 - 60, screenHeight / 2, 40,
+                     ToRenderColor(GRAY));
+          RenderText(&renderList, RENDER_LAYER_HUD, "Press SPACE to continue",
+                     screenWidth / 2 - 120, screenHeight / 2 + 50, 20,
+                     ToRenderColor(DARKGRAY));
         }
 
       } else {
         // Game over screen
-        DrawText("Game Over!", screenWidth / 2 - 100, screenHeight / 2 - 50, 40,
-                 RED);
-        DrawText(TextFormat("Score: %d", score), screenWidth / 2 - 70,
-                 screenHeight / 2, 30, BLACK);
-        DrawText(TextFormat("High Score: %d", highScore), screenWidth / 2 - 90,
-                 screenHeight / 2 + 40, 30, GOLD);
-        DrawText("Press R to Restart", screenWidth / 2 - 100,
-                 screenHeight / 2 + 80, 20, DARKGRAY);
+        RenderText(&renderList, RENDER_LAYER_HUD, "Game Over!",
+                   screenWidth / 2 - 100, screenHeight / 2 - 50, 40,
+                   ToRenderColor(RED));
+        RenderText(&renderList, RENDER_LAYER_HUD,
+                   TextFormat("Score: %d", shown->score), screenWidth / 2 - 70,
+                   screenHeight / 2, 30, ToRenderColor(BLACK));
+        RenderText(&renderList, RENDER_LAYER_HUD,
+                   TextFormat("High Score: %d", highScore),
+                   screenWidth / 2 - 90, screenHeight / 2 + 40, 30,
+                   ToRenderColor(GOLD));
+        if (!replaying)
+          RenderText(&renderList, RENDER_LAYER_HUD, "Press R to Restart",
+                     screenWidth / 2 - 100, screenHeight / 2 + 80, 20,
+                     ToRenderColor(DARKGRAY));
+
+        // Top of the leaderboard
+        for (int i = 0; i < leaderboardCount && i < 5; i++) {
+          RenderText(&renderList, RENDER_LAYER_HUD,
+                     TextFormat("%d. %d", i + 1, leaderboard[i].score),
+                     screenWidth / 2 - 40, screenHeight / 2 + 120 + i * 22, 20,
+                     ToRenderColor(GRAY));
+        }
       }
-    }
-    EndDrawing();
 
-    // Reset the game
-    if (gameOver && IsKeyPressed(KEY_R)) {
-      // Reset player to relative position
-      player.rect.x = 0.5f * screenWidth - 15;
-      player.rect.y = 0.8f * screenHeight;
-      isInvincible = false;
-
-      // Reset the obstacles
-      activeObstacles = INITIAL_OBSTACLES;
-      for (int i = 0; i < MAX_OBSTACLES; i++) {
-        obstacles[i].active = false;
-      }
-      for (int i = 0; i < INITIAL_OBSTACLES; i++) {
-        float relativeX = GetRandomValue(0, 100) / 100.0f;
-        SpawnObstacle(&obstacles[i], screenWidth, baseSpeed, relativeX);
+      if (replaying) {
+        const char *label =
+            !replayDone ? "REPLAY"
+                        : (replayMatched ? "REPLAY DONE: state matches"
+                                         : "REPLAY DONE: state MISMATCH");
+        RenderText(&renderList, RENDER_LAYER_HUD, label,
+                   screenWidth - MeasureText(label, 20) - 10, 10, 20,
+                   ToRenderColor(replayDone && !replayMatched ? RED
+                                                              : DARKGRAY));
       }
 
-      // Reset power-ups
-      for (int i = 0; i < MAX_POWERUPS; i++) {
-        powerUps[i].active = false;
+      if (rewinding) {
+        const char *label = TextFormat(
+            "REWIND -%.1f s",
+            (double)(rewind.newestStep - rewindStep) / SIM_TICK_RATE);
+        RenderText(&renderList, RENDER_LAYER_HUD, label,
+                   screenWidth - MeasureText(label, 20) - 10, 10, 20,
+                   ToRenderColor(DARKGRAY));
       }
-      powerUpSpawnTimer = 0.0f;
 
-      // Reset the floor hit effects
-      for (int i = 0; i < MAX_OBSTACLES; i++) {
-        floorHits[i].active = false;
+      if (autopilot) {
+        const char *label =
+            TextFormat("AUTOPILOT %d rollouts (%.0f/s)", pilot.rollouts,
+                       pilot.rolloutsPerSecond);
+        RenderText(&renderList, RENDER_LAYER_HUD, label,
+                   screenWidth - MeasureText(label, 20) - 10,
+                   screenHeight - 30, 20, ToRenderColor(DARKGRAY));
       }
 
-      // Reset game state
-      score = 0;
-      timePlayed = 0.0f;
-      baseSpeed = 3.0f;
-      nextObstacleScore = 500;
-      gameOver = false;
-      gamePaused = false;
+#ifdef RAYLIBLEARN_PROFILER
+      if (showProfiler)
+        DrawProfilerOverlay(&renderList, screenWidth,
+                            SimTimingGet(&inputLatency),
+                            simThread ? currentInfo.jitter
+                                      : SimTimingGet(&tickJitter));
+#endif
+
+      RenderFlush(&renderList, &renderer);
+      PROFILE_COUNT_DRAWS(renderList.stats.commands);
+    }
+    EndDrawing();
+    PROFILE_END_FRAME();
+
+    // On screen now, EndDrawing() waited for it
+    uint64_t presentNs = ProfilerNow();
+    if (simThread && currentInfo.inputNs > shownInputNs) {
+      SimTimingAdd(&inputLatency, (presentNs - currentInfo.inputNs) / 1e6);
+      shownInputNs = currentInfo.inputNs;
+    } else if (!simThread && consumedNs) {
+      SimTimingAdd(&inputLatency, (presentNs - consumedNs) / 1e6);
+      consumedNs = 0;
     }
   }
 
-  UnloadTexture(invincibilityTexture);
+  SimTimingStats latency = SimTimingGet(&inputLatency);
+  SimTimingStats jitter =
+      simThread ? currentInfo.jitter : SimTimingGet(&tickJitter);
+  printf("%s: input latency p50 %.1f ms, p99 %.1f ms; tick jitter p50 %.2f "
+         "ms, p99 %.2f ms\n",
+         simThread ? "Sim thread" : "Single thread", latency.p50Ms,
+         latency.p99Ms, jitter.p50Ms, jitter.p99Ms);
+  // Leaves game at the last tick
+  SimThreadStop(simThread);
 
+  UnloadTexture(invincibilityTexture);
+  AudioStats audio;
+  AudioMixerClose(mixer, &audio);
+  if (mixer)
+    printf("Audio: %lld triggers, %lld played, %lld coalesced, %lld without "
+           "a voice, %lld dropped\n",
+           audio.posted, audio.played, audio.coalesced, audio.voiceDrops,
+           audio.queueDrops);
+  SoundVoicesFree(&soundVoices);
   UnloadSound(collisionSound);
   UnloadSound(powerUpSound);
   UnloadSound(floorHitSound);
 
+  if (threaded) {
+    SimFree(&views[0]);
+    SimFree(&views[1]);
+  }
+  status = 0;
+
+freeRewind:
+  if (rewindEnabled)
+    RewindFree(&rewind);
+freePilot:
+  AutopilotFree(&pilot);
+closeScores:
+  HighScoreClose(scores);
+closeRecorder:
+  if (recorder && !ReplayWriterClose(recorder, &game))
+    printf("Error writing replay %s\n", recordPath);
+  SimFree(&game);
+freeRenderList:
+  RenderListFree(&renderList);
+closeWindow:
+  if (assets)
+    AssetsClose(assets);
   CloseAudioDevice();
   CloseWindow();
-  return 0;
+closeReplay:
+  if (replaying)
+    ReplayReaderClose(&replay);
+  return status;
 }
@@ -0,0 +1,250 @@
+#include "obstacles.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OBSTACLE_KERNEL "avx2"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define OBSTACLE_KERNEL "sse2"
+#else
+#define OBSTACLE_KERNEL "scalar"
+#endif
+
+// Bytes per obstacle across all arrays
+#define OBSTACLE_STRIDE (5 * sizeof(float) + sizeof(int32_t) + sizeof(uint8_t))
+
+static bool Allocate(ObstacleStore *store, int capacity) {
+  // Keep every array 32-byte aligned relative to the block
+  capacity = (capacity + 31) & ~31;
+  char *block = malloc((size_t)capacity * OBSTACLE_STRIDE);
+  if (!block)
+    return false;
+
+  float *floats = (float *)block;
+  store->x = floats;
+  store->y = floats + capacity;
+  store->w = floats + 2 * capacity;
+  store->h = floats + 3 * capacity;
+  store->speed = floats + 4 * capacity;
+  store->scratch = (int32_t *)(floats + 5 * capacity);
+  store->color = (uint8_t *)(store->scratch + capacity);
+  store->block = block;
+  store->capacity = capacity;
+  return true;
+}
+
+bool ObstacleStoreInit(ObstacleStore *store, int capacity) {
+  memset(store, 0, sizeof(*store));
+  return Allocate(store, capacity > 0 ? capacity : 32);
+}
+
+void ObstacleStoreFree(ObstacleStore *store) {
+  free(store->block);
+  memset(store, 0, sizeof(*store));
+}
+
+bool ObstacleStoreReserve(ObstacleStore *store, int capacity) {
+  if (capacity <= store->capacity)
+    return true;
+
+  ObstacleStore grown = *store;
+  if (!Allocate(&grown, capacity))
+    return false;
+  size_t n = (size_t)store->count;
+  memcpy(grown.x, store->x, n * sizeof(float));
+  memcpy(grown.y, store->y, n * sizeof(float));
+  memcpy(grown.w, store->w, n * sizeof(float));
+  memcpy(grown.h, store->h, n * sizeof(float));
+  memcpy(grown.speed, store->speed, n * sizeof(float));
+  memcpy(grown.color, store->color, n);
+  free(store->block);
+  *store = grown;
+  return true;
+}
+
+int ObstacleStorePush(ObstacleStore *store, float x, float y, float w,
+                      float h, float speed, uint8_t color) {
+  if (store->count == store->capacity &&
+      !ObstacleStoreReserve(store, store->capacity * 2))
+    return -1;
+  int i = store->count++;
+  store->x[i] = x;
+  store->y[i] = y;
+  store->w[i] = w;
+  store->h[i] = h;
+  store->speed[i] = speed;
+  store->color[i] = color;
+  return i;
+}
+
+void ObstaclesIntegrateScalar(ObstacleStore *store, float frames) {
+  float *y = store->y;
+  const float *speed = store->speed;
+  for (int i = 0; i < store->count; i++)
+    y[i] += speed[i] * frames;
+}
+
+int ObstaclesFindBelowScalar(ObstacleStore *store, float limit) {
+  int found = 0;
+  for (int i = 0; i < store->count; i++) {
+    if (store->y[i] > limit)
+      store->scratch[found++] = i;
+  }
+  return found;
+}
+
+int ObstaclesFirstOverlapScalar(const ObstacleStore *store, float x, float y,
+                                float w, float h) {
+  for (int i = 0; i < store->count; i++) {
+    if (x < store->x[i] + store->w[i] && x + w > store->x[i] &&
+        y < store->y[i] + store->h[i] && y + h > store->y[i])
+      return i;
+  }
+  return -1;
+}
+
+#if defined(__AVX2__)
+
+void ObstaclesIntegrate(ObstacleStore *store, float frames) {
+  float *y = store->y;
+  const float *speed = store->speed;
+  __m256 f = _mm256_set1_ps(frames);
+  int i = 0;
+  for (; i + 8 <= store->count; i += 8) {
+    __m256 v = _mm256_mul_ps(_mm256_loadu_ps(speed + i), f);
+    _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), v));
+  }
+  for (; i < store->count; i++)
+    y[i] += speed[i] * frames;
+}
+
+int ObstaclesFindBelow(ObstacleStore *store, float limit) {
+  __m256 l = _mm256_set1_ps(limit);
+  int found = 0;
+  int i = 0;
+  for (; i + 8 <= store->count; i += 8) {
+    __m256 below = _mm256_cmp_ps(_mm256_loadu_ps(store->y + i), l, _CMP_GT_OQ);
+    unsigned mask = (unsigned)_mm256_movemask_ps(below);
+    while (mask) {
+      store->scratch[found++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < store->count; i++) {
+    if (store->y[i] > limit)
+      store->scratch[found++] = i;
+  }
+  return found;
+}
+
+int ObstaclesFirstOverlap(const ObstacleStore *store, float x, float y,
+                          float w, float h) {
+  __m256 px = _mm256_set1_ps(x);
+  __m256 py = _mm256_set1_ps(y);
+  __m256 pr = _mm256_set1_ps(x + w);
+  __m256 pb = _mm256_set1_ps(y + h);
+  int i = 0;
+  for (; i + 8 <= store->count; i += 8) {
+    __m256 ox = _mm256_loadu_ps(store->x + i);
+    __m256 oy = _mm256_loadu_ps(store->y + i);
+    __m256 right = _mm256_add_ps(ox, _mm256_loadu_ps(store->w + i));
+    __m256 bottom = _mm256_add_ps(oy, _mm256_loadu_ps(store->h + i));
+    __m256 hit = _mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(px, right, _CMP_LT_OQ),
+                      _mm256_cmp_ps(pr, ox, _CMP_GT_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(py, bottom, _CMP_LT_OQ),
+                      _mm256_cmp_ps(pb, oy, _CMP_GT_OQ)));
+    unsigned mask = (unsigned)_mm256_movemask_ps(hit);
+    if (mask)
+      return i + __builtin_ctz(mask);
+  }
+  for (; i < store->count; i++) {
+    if (x < store->x[i] + store->w[i] && x + w > store->x[i] &&
+        y < store->y[i] + store->h[i] && y + h > store->y[i])
+      return i;
+  }
+  return -1;
+}
+
+#elif defined(__SSE2__)
+
+void ObstaclesIntegrate(ObstacleStore *store, float frames) {
+  float *y = store->y;
+  const float *speed = store->speed;
+  __m128 f = _mm_set1_ps(frames);
+  int i = 0;
+  for (; i + 4 <= store->count; i += 4) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(speed + i), f);
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), v));
+  }
+  for (; i < store->count; i++)
+    y[i] += speed[i] * frames;
+}
+
+int ObstaclesFindBelow(ObstacleStore *store, float limit) {
+  __m128 l = _mm_set1_ps(limit);
+  int found = 0;
+  int i = 0;
+  for (; i + 4 <= store->count; i += 4) {
+    unsigned mask =
+        (unsigned)_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(store->y + i), l));
+    while (mask) {
+      store->scratch[found++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < store->count; i++) {
+    if (store->y[i] > limit)
+      store->scratch[found++] = i;
+  }
+  return found;
+}
+
+int ObstaclesFirstOverlap(const ObstacleStore *store, float x, float y,
+                          float w, float h) {
+  __m128 px = _mm_set1_ps(x);
+  __m128 py = _mm_set1_ps(y);
+  __m128 pr = _mm_set1_ps(x + w);
+  __m128 pb = _mm_set1_ps(y + h);
+  int i = 0;
+  for (; i + 4 <= store->count; i += 4) {
+    __m128 ox = _mm_loadu_ps(store->x + i);
+    __m128 oy = _mm_loadu_ps(store->y + i);
+    __m128 right = _mm_add_ps(ox, _mm_loadu_ps(store->w + i));
+    __m128 bottom = _mm_add_ps(oy, _mm_loadu_ps(store->h + i));
+    __m128 hit =
+        _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(px, right), _mm_cmpgt_ps(pr, ox)),
+                   _mm_and_ps(_mm_cmplt_ps(py, bottom), _mm_cmpgt_ps(pb, oy)));
+    unsigned mask = (unsigned)_mm_movemask_ps(hit);
+    if (mask)
+      return i + __builtin_ctz(mask);
+  }
+  for (; i < store->count; i++) {
+    if (x < store->x[i] + store->w[i] && x + w > store->x[i] &&
+        y < store->y[i] + store->h[i] && y + h > store->y[i])
+      return i;
+  }
+  return -1;
+}
+
+#else
+
+void ObstaclesIntegrate(ObstacleStore *store, float frames) {
+  ObstaclesIntegrateScalar(store, frames);
+}
+
+int ObstaclesFindBelow(ObstacleStore *store, float limit) {
+  return ObstaclesFindBelowScalar(store, limit);
+}
+
+int ObstaclesFirstOverlap(const ObstacleStore *store, float x, float y,
+                          float w, float h) {
+  return ObstaclesFirstOverlapScalar(store, x, y, w, h);
+}
+
+#endif
+
+const char *ObstacleKernelName(void) { return OBSTACLE_KERNEL; }
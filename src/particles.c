@@ -0,0 +1,238 @@
+#include "particles.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define PARTICLE_FLOATS 8
+// Bytes per particle across all arrays
+#define PARTICLE_STRIDE                                                        \
+  (PARTICLE_FLOATS * sizeof(float) + sizeof(int32_t) + sizeof(uint8_t))
+
+static bool Allocate(ParticleStore *store, int capacity) {
+  // Keep every array 32-byte aligned relative to the block
+  capacity = (capacity + 31) & ~31;
+  char *block = malloc((size_t)capacity * PARTICLE_STRIDE);
+  if (!block)
+    return false;
+
+  float *floats = (float *)block;
+  store->x = floats;
+  store->y = floats + capacity;
+  store->vx = floats + 2 * capacity;
+  store->vy = floats + 3 * capacity;
+  store->radius = floats + 4 * capacity;
+  store->growth = floats + 5 * capacity;
+  store->alpha = floats + 6 * capacity;
+  store->fade = floats + 7 * capacity;
+  store->scratch = (int32_t *)(floats + PARTICLE_FLOATS * capacity);
+  store->color = (uint8_t *)(store->scratch + capacity);
+  store->block = block;
+  store->capacity = capacity;
+  return true;
+}
+
+bool ParticleStoreInit(ParticleStore *store, int capacity) {
+  memset(store, 0, sizeof(*store));
+  return Allocate(store, capacity > 0 ? capacity : 32);
+}
+
+void ParticleStoreFree(ParticleStore *store) {
+  free(store->block);
+  memset(store, 0, sizeof(*store));
+}
+
+bool ParticleStoreReserve(ParticleStore *store, int capacity) {
+  if (capacity <= store->capacity)
+    return true;
+
+  ParticleStore grown = *store;
+  if (!Allocate(&grown, capacity))
+    return false;
+  size_t n = (size_t)store->count;
+  memcpy(grown.x, store->x, n * sizeof(float));
+  memcpy(grown.y, store->y, n * sizeof(float));
+  memcpy(grown.vx, store->vx, n * sizeof(float));
+  memcpy(grown.vy, store->vy, n * sizeof(float));
+  memcpy(grown.radius, store->radius, n * sizeof(float));
+  memcpy(grown.growth, store->growth, n * sizeof(float));
+  memcpy(grown.alpha, store->alpha, n * sizeof(float));
+  memcpy(grown.fade, store->fade, n * sizeof(float));
+  memcpy(grown.color, store->color, n);
+  free(store->block);
+  *store = grown;
+  return true;
+}
+
+int ParticleStorePush(ParticleStore *store, const Particle *particle) {
+  if (store->count == store->capacity &&
+      !ParticleStoreReserve(store, store->capacity * 2))
+    return -1;
+  int i = store->count++;
+  store->x[i] = particle->x;
+  store->y[i] = particle->y;
+  store->vx[i] = particle->vx;
+  store->vy[i] = particle->vy;
+  store->radius[i] = particle->radius;
+  store->growth[i] = particle->growth;
+  store->alpha[i] = particle->alpha;
+  store->fade[i] = particle->fade;
+  store->color[i] = particle->color;
+  return i;
+}
+
+void ParticleStoreRemove(ParticleStore *store, int i) {
+  int last = --store->count;
+  store->x[i] = store->x[last];
+  store->y[i] = store->y[last];
+  store->vx[i] = store->vx[last];
+  store->vy[i] = store->vy[last];
+  store->radius[i] = store->radius[last];
+  store->growth[i] = store->growth[last];
+  store->alpha[i] = store->alpha[last];
+  store->fade[i] = store->fade[last];
+  store->color[i] = store->color[last];
+}
+
+// Removes the particles listed in scratch (ascending). Highest index first:
+// everything past it is already alive, so every swap brings a live one in.
+static int RemoveFound(ParticleStore *store, int found) {
+  for (int k = found - 1; k >= 0; k--)
+    ParticleStoreRemove(store, store->scratch[k]);
+  return found;
+}
+
+void ParticlesIntegrateScalar(ParticleStore *store, float frames) {
+  for (int i = 0; i < store->count; i++) {
+    store->x[i] += store->vx[i] * frames;
+    store->y[i] += store->vy[i] * frames;
+    store->radius[i] += store->growth[i] * frames;
+    store->alpha[i] -= store->fade[i] * frames;
+  }
+}
+
+int ParticlesExpireScalar(ParticleStore *store) {
+  int found = 0;
+  for (int i = 0; i < store->count; i++) {
+    if (store->alpha[i] <= 0.0f)
+      store->scratch[found++] = i;
+  }
+  return RemoveFound(store, found);
+}
+
+#if defined(__AVX2__)
+
+// One pass over the arrays, the store is larger than the caches at the
+// counts where this matters
+void ParticlesIntegrate(ParticleStore *store, float frames) {
+  __m256 f = _mm256_set1_ps(frames);
+  int i = 0;
+  for (; i + 8 <= store->count; i += 8) {
+    __m256 x = _mm256_loadu_ps(store->x + i);
+    __m256 y = _mm256_loadu_ps(store->y + i);
+    __m256 radius = _mm256_loadu_ps(store->radius + i);
+    __m256 alpha = _mm256_loadu_ps(store->alpha + i);
+    x = _mm256_add_ps(x, _mm256_mul_ps(_mm256_loadu_ps(store->vx + i), f));
+    y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_loadu_ps(store->vy + i), f));
+    radius = _mm256_add_ps(
+        radius, _mm256_mul_ps(_mm256_loadu_ps(store->growth + i), f));
+    alpha = _mm256_sub_ps(alpha,
+                          _mm256_mul_ps(_mm256_loadu_ps(store->fade + i), f));
+    _mm256_storeu_ps(store->x + i, x);
+    _mm256_storeu_ps(store->y + i, y);
+    _mm256_storeu_ps(store->radius + i, radius);
+    _mm256_storeu_ps(store->alpha + i, alpha);
+  }
+  for (; i < store->count; i++) {
+    store->x[i] += store->vx[i] * frames;
+    store->y[i] += store->vy[i] * frames;
+    store->radius[i] += store->growth[i] * frames;
+    store->alpha[i] -= store->fade[i] * frames;
+  }
+}
+
+int ParticlesExpire(ParticleStore *store) {
+  __m256 zero = _mm256_setzero_ps();
+  int found = 0;
+  int i = 0;
+  for (; i + 8 <= store->count; i += 8) {
+    __m256 dead =
+        _mm256_cmp_ps(_mm256_loadu_ps(store->alpha + i), zero, _CMP_LE_OQ);
+    unsigned mask = (unsigned)_mm256_movemask_ps(dead);
+    while (mask) {
+      store->scratch[found++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < store->count; i++) {
+    if (store->alpha[i] <= 0.0f)
+      store->scratch[found++] = i;
+  }
+  return RemoveFound(store, found);
+}
+
+#elif defined(__SSE2__)
+
+// One pass over the arrays, the store is larger than the caches at the
+// counts where this matters
+void ParticlesIntegrate(ParticleStore *store, float frames) {
+  __m128 f = _mm_set1_ps(frames);
+  int i = 0;
+  for (; i + 4 <= store->count; i += 4) {
+    __m128 x = _mm_loadu_ps(store->x + i);
+    __m128 y = _mm_loadu_ps(store->y + i);
+    __m128 radius = _mm_loadu_ps(store->radius + i);
+    __m128 alpha = _mm_loadu_ps(store->alpha + i);
+    x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(store->vx + i), f));
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(store->vy + i), f));
+    radius =
+        _mm_add_ps(radius, _mm_mul_ps(_mm_loadu_ps(store->growth + i), f));
+    alpha = _mm_sub_ps(alpha, _mm_mul_ps(_mm_loadu_ps(store->fade + i), f));
+    _mm_storeu_ps(store->x + i, x);
+    _mm_storeu_ps(store->y + i, y);
+    _mm_storeu_ps(store->radius + i, radius);
+    _mm_storeu_ps(store->alpha + i, alpha);
+  }
+  for (; i < store->count; i++) {
+    store->x[i] += store->vx[i] * frames;
+    store->y[i] += store->vy[i] * frames;
+    store->radius[i] += store->growth[i] * frames;
+    store->alpha[i] -= store->fade[i] * frames;
+  }
+}
+
+int ParticlesExpire(ParticleStore *store) {
+  __m128 zero = _mm_setzero_ps();
+  int found = 0;
+  int i = 0;
+  for (; i + 4 <= store->count; i += 4) {
+    unsigned mask = (unsigned)_mm_movemask_ps(
+        _mm_cmple_ps(_mm_loadu_ps(store->alpha + i), zero));
+    while (mask) {
+      store->scratch[found++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < store->count; i++) {
+    if (store->alpha[i] <= 0.0f)
+      store->scratch[found++] = i;
+  }
+  return RemoveFound(store, found);
+}
+
+#else
+
+void ParticlesIntegrate(ParticleStore *store, float frames) {
+  ParticlesIntegrateScalar(store, frames);
+}
+
+int ParticlesExpire(ParticleStore *store) {
+  return ParticlesExpireScalar(store);
+}
+
+#endif
@@ -0,0 +1,201 @@
+#define _POSIX_C_SOURCE 200809L
+#include "profiler.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+typedef struct {
+  _Atomic uint64_t seq; // index + 1 once the slot is fully written
+  uint64_t start;
+  uint32_t duration;
+  uint16_t zone;
+  uint16_t thread;
+} ProfileEvent;
+
+// Totals of the frame in progress, added to from any thread
+static _Atomic uint64_t currentNs[PROFILE_ZONE_COUNT];
+static _Atomic uint32_t currentDraws;
+
+// Finished frames. Only the render thread writes them, head is published
+// with release so readers see complete slots.
+static ProfileFrame history[PROFILER_HISTORY];
+static _Atomic uint64_t historyHead;
+static uint64_t lastFrameEnd;
+
+static ProfileEvent events[PROFILER_MAX_EVENTS];
+static _Atomic uint64_t eventHead;
+
+static _Atomic uint16_t nextThreadId;
+static _Thread_local uint16_t threadId;
+static _Thread_local bool suspended;
+
+static const char *zoneNames[PROFILE_ZONE_COUNT] = {
+    "frame",    "sim",       "spawn",     "input", "powerups",
+    "invincib", "obstacles", "particles", "draw",  "autopilot"};
+
+uint64_t ProfilerNow(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000ull +
+         (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000ull /
+             frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void ProfilerRecord(ProfileZone zone, uint64_t startNs) {
+  if (suspended)
+    return;
+  uint64_t duration = ProfilerNow() - startNs;
+  atomic_fetch_add_explicit(&currentNs[zone], duration, memory_order_relaxed);
+
+  if (threadId == 0)
+    threadId = atomic_fetch_add(&nextThreadId, 1) + 1;
+  uint64_t index = atomic_fetch_add_explicit(&eventHead, 1,
+                                             memory_order_relaxed);
+  ProfileEvent *event = &events[index % PROFILER_MAX_EVENTS];
+  // Invalidate the slot before touching it, readers that see the new
+  // payload under the old seq then fail their re-check
+  atomic_store_explicit(&event->seq, 0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  event->start = startNs;
+  event->duration = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
+  event->zone = (uint16_t)zone;
+  event->thread = threadId;
+  atomic_store_explicit(&event->seq, index + 1, memory_order_release);
+}
+
+void ProfilerSuspend(bool suspend) { suspended = suspend; }
+
+void ProfilerCountDraws(uint32_t count) {
+  atomic_fetch_add_explicit(&currentDraws, count, memory_order_relaxed);
+}
+
+void ProfilerEndFrame(void) {
+  uint64_t now = ProfilerNow();
+  uint64_t head = atomic_load_explicit(&historyHead, memory_order_relaxed);
+  ProfileFrame *frame = &history[head % PROFILER_HISTORY];
+
+  frame->frame = head;
+  for (int i = 0; i < PROFILE_ZONE_COUNT; i++)
+    frame->zoneNs[i] =
+        atomic_exchange_explicit(&currentNs[i], 0, memory_order_relaxed);
+  frame->zoneNs[PROFILE_FRAME] = lastFrameEnd ? now - lastFrameEnd : 0;
+  frame->drawCalls =
+      atomic_exchange_explicit(&currentDraws, 0, memory_order_relaxed);
+  lastFrameEnd = now;
+
+  atomic_store_explicit(&historyHead, head + 1, memory_order_release);
+}
+
+const char *ProfilerZoneName(ProfileZone zone) { return zoneNames[zone]; }
+
+static int CompareU64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static ProfileStats Percentiles(uint64_t *values, int n, double scale) {
+  qsort(values, n, sizeof(uint64_t), CompareU64);
+  return (ProfileStats){values[(n - 1) / 2] * scale,
+                        values[(n - 1) * 99 / 100] * scale};
+}
+
+// Copies the finished frames, oldest first
+static int CopyHistory(ProfileFrame *out) {
+  uint64_t head = atomic_load_explicit(&historyHead, memory_order_acquire);
+  int n = head < PROFILER_HISTORY ? (int)head : PROFILER_HISTORY;
+  for (int i = 0; i < n; i++)
+    out[i] = history[(head - n + i) % PROFILER_HISTORY];
+  return n;
+}
+
+int ProfilerStats(ProfileStats stats[PROFILE_ZONE_COUNT],
+                  ProfileStats *drawCalls) {
+  static ProfileFrame frames[PROFILER_HISTORY];
+  uint64_t values[PROFILER_HISTORY];
+  int n = CopyHistory(frames);
+  if (n == 0) {
+    memset(stats, 0, PROFILE_ZONE_COUNT * sizeof(ProfileStats));
+    *drawCalls = (ProfileStats){0};
+    return 0;
+  }
+
+  for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+    for (int i = 0; i < n; i++)
+      values[i] = frames[i].zoneNs[zone];
+    stats[zone] = Percentiles(values, n, 1e-6);
+  }
+  for (int i = 0; i < n; i++)
+    values[i] = frames[i].drawCalls;
+  *drawCalls = Percentiles(values, n, 1.0);
+  return n;
+}
+
+bool ProfilerExportCsv(const char *path) {
+  static ProfileFrame frames[PROFILER_HISTORY];
+  FILE *file = fopen(path, "w");
+  if (!file)
+    return false;
+
+  fprintf(file, "frame");
+  for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+    fprintf(file, ",%s_us", zoneNames[zone]);
+  fprintf(file, ",draw_calls\n");
+
+  int n = CopyHistory(frames);
+  for (int i = 0; i < n; i++) {
+    fprintf(file, "%llu", (unsigned long long)frames[i].frame);
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+      fprintf(file, ",%.3f", frames[i].zoneNs[zone] / 1e3);
+    fprintf(file, ",%u\n", frames[i].drawCalls);
+  }
+  return fclose(file) == 0;
+}
+
+bool ProfilerExportTrace(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file)
+    return false;
+
+  fprintf(file, "{\"traceEvents\":[\n");
+  uint64_t head = atomic_load_explicit(&eventHead, memory_order_acquire);
+  uint64_t first = head > PROFILER_MAX_EVENTS ? head - PROFILER_MAX_EVENTS : 0;
+  bool comma = false;
+  for (uint64_t index = first; index < head; index++) {
+    const ProfileEvent *event = &events[index % PROFILER_MAX_EVENTS];
+    // Skip slots that are being rewritten, before or while we copy them
+    if (atomic_load_explicit(&event->seq, memory_order_acquire) != index + 1)
+      continue;
+    ProfileEvent copy;
+    copy.start = event->start;
+    copy.duration = event->duration;
+    copy.zone = event->zone;
+    copy.thread = event->thread;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&event->seq, memory_order_relaxed) != index + 1)
+      continue;
+    fprintf(file,
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":1,\"tid\":%u}",
+            comma ? ",\n" : "", zoneNames[copy.zone], copy.start / 1e3,
+            copy.duration / 1e3, copy.thread);
+    comma = true;
+  }
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
@@ -0,0 +1,295 @@
+#include "render.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RENDER_MIN_COMMANDS 1024
+#define RENDER_MIN_TEXT 4096
+
+bool RenderListInit(RenderList *list) {
+  memset(list, 0, sizeof(*list));
+  list->commands = malloc(RENDER_MIN_COMMANDS * sizeof(RenderCommand));
+  list->sorted = malloc(RENDER_MIN_COMMANDS * sizeof(RenderCommand));
+  list->keys = malloc(RENDER_MIN_COMMANDS * sizeof(uint64_t));
+  list->swap = malloc(RENDER_MIN_COMMANDS * sizeof(uint64_t));
+  list->text = malloc(RENDER_MIN_TEXT);
+  list->capacity = RENDER_MIN_COMMANDS;
+  list->textCapacity = RENDER_MIN_TEXT;
+  if (!list->commands || !list->sorted || !list->keys || !list->swap ||
+      !list->text) {
+    RenderListFree(list);
+    return false;
+  }
+  return true;
+}
+
+void RenderListFree(RenderList *list) {
+  free(list->commands);
+  free(list->sorted);
+  free(list->keys);
+  free(list->swap);
+  free(list->text);
+  memset(list, 0, sizeof(*list));
+}
+
+void RenderBegin(RenderList *list, RenderColor clear) {
+  list->count = 0;
+  list->textUsed = 0;
+  list->dropped = 0;
+  list->clearColor = clear;
+}
+
+// Doubles the command buffer and the sort scratch together
+static bool Grow(RenderList *list) {
+  int capacity = list->capacity * 2;
+  RenderCommand *commands =
+      realloc(list->commands, (size_t)capacity * sizeof(RenderCommand));
+  if (!commands)
+    return false;
+  list->commands = commands;
+  // The scratch holds nothing between flushes
+  RenderCommand *sorted = malloc((size_t)capacity * sizeof(RenderCommand));
+  uint64_t *keys = malloc((size_t)capacity * sizeof(uint64_t));
+  uint64_t *swap = malloc((size_t)capacity * sizeof(uint64_t));
+  if (!sorted || !keys || !swap) {
+    free(sorted);
+    free(keys);
+    free(swap);
+    return false;
+  }
+  free(list->sorted);
+  free(list->keys);
+  free(list->swap);
+  list->sorted = sorted;
+  list->keys = keys;
+  list->swap = swap;
+  list->capacity = capacity;
+  return true;
+}
+
+static RenderCommand *Push(RenderList *list, RenderLayer layer,
+                           RenderPrimitive primitive, RenderColor color) {
+  if (list->count == list->capacity && !Grow(list)) {
+    list->dropped++;
+    return NULL;
+  }
+  RenderCommand *command = &list->commands[list->count++];
+  memset(command, 0, sizeof(*command));
+  command->layer = (uint8_t)layer;
+  command->primitive = (uint8_t)primitive;
+  command->color = color;
+  return command;
+}
+
+void RenderRect(RenderList *list, RenderLayer layer, float x, float y,
+                float width, float height, RenderColor color) {
+  RenderCommand *command = Push(list, layer, RENDER_RECT, color);
+  if (command) {
+    command->x = x;
+    command->y = y;
+    command->width = width;
+    command->height = height;
+  }
+}
+
+void RenderRectLines(RenderList *list, RenderLayer layer, float x, float y,
+                     float width, float height, RenderColor color) {
+  RenderCommand *command = Push(list, layer, RENDER_RECT_LINES, color);
+  if (command) {
+    command->x = x;
+    command->y = y;
+    command->width = width;
+    command->height = height;
+  }
+}
+
+void RenderCircle(RenderList *list, RenderLayer layer, float x, float y,
+                  float radius, RenderColor color) {
+  RenderCommand *command = Push(list, layer, RENDER_CIRCLE, color);
+  if (command) {
+    command->x = x;
+    command->y = y;
+    command->width = radius;
+  }
+}
+
+void RenderTexture(RenderList *list, RenderLayer layer, RenderImage image,
+                   float x, float y, float width, float height,
+                   RenderColor tint) {
+  RenderCommand *command = Push(list, layer, RENDER_TEXTURE, tint);
+  if (command) {
+    command->x = x;
+    command->y = y;
+    command->width = width;
+    command->height = height;
+    command->sourceWidth = image.width;
+    command->sourceHeight = image.height;
+    command->image = image;
+  }
+}
+
+void RenderText(RenderList *list, RenderLayer layer, const char *text,
+                float x, float y, float size, RenderColor color) {
+  size_t length = strlen(text) + 1;
+  if (list->textUsed + length > list->textCapacity) {
+    size_t capacity = list->textCapacity * 2;
+    while (list->textUsed + length > capacity)
+      capacity *= 2;
+    // Offsets are 32 bit
+    char *grown =
+        capacity <= UINT32_MAX ? realloc(list->text, capacity) : NULL;
+    if (!grown) {
+      list->dropped++;
+      return;
+    }
+    list->text = grown;
+    list->textCapacity = capacity;
+  }
+  RenderCommand *command = Push(list, layer, RENDER_TEXT, color);
+  if (command) {
+    command->x = x;
+    command->y = y;
+    command->width = size;
+    command->text = (uint32_t)list->textUsed;
+    memcpy(list->text + list->textUsed, text, length);
+    list->textUsed += length;
+  }
+}
+
+const char *RenderCommandText(const RenderList *list,
+                              const RenderCommand *command) {
+  return list->text + command->text;
+}
+
+RenderColor RenderFade(RenderColor color, float alpha) {
+  if (alpha < 0.0f)
+    alpha = 0.0f;
+  else if (alpha > 1.0f)
+    alpha = 1.0f;
+  color.a = (uint8_t)(255.0f * alpha);
+  return color;
+}
+
+// Layer, then primitive, then texture. Only the low 16 bits of the texture
+// id take part, which is plenty for GL names; SameBatch() compares all of it.
+static uint32_t BatchKey(const RenderCommand *command) {
+  return (uint32_t)command->layer << 24 | (uint32_t)command->primitive << 16 |
+         (command->image.id & 0xFFFF);
+}
+
+static bool SameBatch(const RenderCommand *a, const RenderCommand *b) {
+  return a->layer == b->layer && a->primitive == b->primitive &&
+         a->image.id == b->image.id;
+}
+
+// Stable LSD radix sort on the batch key bytes (the high half of each
+// entry). Bytes every key shares are skipped, a frame usually only has a
+// handful of distinct keys.
+static uint64_t *SortKeys(uint64_t *keys, uint64_t *swap, int count) {
+  uint32_t histogram[4][256] = {0};
+  for (int i = 0; i < count; i++) {
+    for (int b = 0; b < 4; b++)
+      histogram[b][(keys[i] >> (32 + 8 * b)) & 0xFF]++;
+  }
+  for (int b = 0; b < 4; b++) {
+    int shift = 32 + 8 * b;
+    if (histogram[b][(keys[0] >> shift) & 0xFF] == (uint32_t)count)
+      continue;
+    uint32_t offsets[256];
+    uint32_t sum = 0;
+    for (int v = 0; v < 256; v++) {
+      offsets[v] = sum;
+      sum += histogram[b][v];
+    }
+    for (int i = 0; i < count; i++)
+      swap[offsets[(keys[i] >> shift) & 0xFF]++] = keys[i];
+    uint64_t *t = keys;
+    keys = swap;
+    swap = t;
+  }
+  return keys;
+}
+
+RenderStats RenderFlush(RenderList *list, const RenderBackend *backend) {
+  int count = list->count;
+  RenderStats stats = {.commands = count, .dropped = list->dropped};
+  if (backend->clear)
+    backend->clear(backend->context, list->clearColor);
+
+  // Recording order is also the tie break, so most frames arrive sorted
+  bool ordered = true;
+  for (int i = 0; i < count; i++) {
+    uint32_t key = BatchKey(&list->commands[i]);
+    list->keys[i] = (uint64_t)key << 32 | (uint32_t)i;
+    if (i == 0 || !SameBatch(&list->commands[i], &list->commands[i - 1]))
+      stats.unsortedBatches++;
+    if (i > 0 && list->keys[i] < list->keys[i - 1])
+      ordered = false;
+  }
+
+  const RenderCommand *commands = list->commands;
+  if (!ordered) {
+    const uint64_t *keys = SortKeys(list->keys, list->swap, count);
+    for (int i = 0; i < count; i++)
+      list->sorted[i] = list->commands[(uint32_t)keys[i]];
+    commands = list->sorted;
+  }
+
+  int start = 0;
+  for (int i = 1; i <= count; i++) {
+    if (i == count || !SameBatch(&commands[i], &commands[start])) {
+      backend->batch(backend->context, list, commands + start, i - start);
+      stats.batches++;
+      start = i;
+    }
+  }
+  list->stats = stats;
+  return stats;
+}
+
+static void NullClear(void *context, RenderColor color) {
+  (void)color;
+  RenderNullCounts *counts = context;
+  counts->frames++;
+}
+
+static void NullBatch(void *context, const RenderList *list,
+                      const RenderCommand *commands, int count) {
+  (void)list;
+  RenderNullCounts *counts = context;
+  counts->batches++;
+  counts->commands += count;
+  counts->primitives[commands[0].primitive] += count;
+}
+
+RenderBackend RenderNullBackend(RenderNullCounts *counts) {
+  return (RenderBackend){counts, NullClear, NullBatch};
+}
+
+const char *HudTextInt(HudText *hud, const char *format, int value) {
+  if (!hud->valid || hud->key != value) {
+    snprintf(hud->text, sizeof(hud->text), format, value);
+    hud->key = value;
+    hud->valid = true;
+    hud->rebuilds++;
+  }
+  return hud->text;
+}
+
+const char *HudTextFloat(HudText *hud, const char *format, float value,
+                         int decimals) {
+  double scale = 1.0;
+  for (int d = 0; d < decimals; d++)
+    scale *= 10.0;
+  long long key = llround(value * scale);
+  if (!hud->valid || hud->key != key) {
+    // Formatted from the rounded value, so the text matches the key
+    snprintf(hud->text, sizeof(hud->text), format, key / scale);
+    hud->key = key;
+    hud->valid = true;
+    hud->rebuilds++;
+  }
+  return hud->text;
+}
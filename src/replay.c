@@ -0,0 +1,232 @@
+#define _POSIX_C_SOURCE 200809L
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define REPLAY_MAGIC "RLRP"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 28
+
+struct ReplayWriter {
+  FILE *file;
+  SimInput runInput;
+  uint64_t runLength;
+  uint64_t steps;
+  char buffer[1 << 16];
+};
+
+static void PutLE(uint8_t *p, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++)
+    p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t GetLE(const uint8_t *p, int bytes) {
+  uint64_t v = 0;
+  for (int i = 0; i < bytes; i++)
+    v |= (uint64_t)p[i] << (8 * i);
+  return v;
+}
+
+static uint32_t FloatBits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+static float BitsFloat(uint32_t bits) {
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static void PutVarint(FILE *file, uint64_t v) {
+  uint8_t bytes[10];
+  int n = 0;
+  do {
+    bytes[n] = v & 0x7F;
+    v >>= 7;
+    if (v)
+      bytes[n] |= 0x80;
+    n++;
+  } while (v);
+  fwrite(bytes, 1, n, file);
+}
+
+static bool GetVarint(ReplayReader *reader, uint64_t *v) {
+  *v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (reader->pos >= reader->size)
+      return false;
+    uint8_t byte = reader->data[reader->pos++];
+    *v |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+ReplayWriter *ReplayWriterOpen(const char *path, const ReplayHeader *header) {
+  ReplayWriter *writer = calloc(1, sizeof(*writer));
+  if (!writer)
+    return NULL;
+  writer->file = fopen(path, "wb");
+  if (!writer->file) {
+    free(writer);
+    return NULL;
+  }
+  // Runs are only a few bytes, a big buffer keeps writes rare
+  setvbuf(writer->file, writer->buffer, _IOFBF, sizeof(writer->buffer));
+
+  uint8_t bytes[REPLAY_HEADER_SIZE];
+  memcpy(bytes, REPLAY_MAGIC, 4);
+  PutLE(bytes + 4, REPLAY_VERSION, 2);
+  PutLE(bytes + 6, 0, 2);
+  PutLE(bytes + 8, header->seed, 8);
+  PutLE(bytes + 16, FloatBits(header->screenWidth), 4);
+  PutLE(bytes + 20, FloatBits(header->screenHeight), 4);
+  PutLE(bytes + 24, (uint32_t)header->swarmObstacles, 4);
+  fwrite(bytes, 1, sizeof(bytes), writer->file);
+  return writer;
+}
+
+static void FlushRun(ReplayWriter *writer) {
+  if (writer->runLength == 0)
+    return;
+  PutVarint(writer->file, writer->runLength);
+  fputc(writer->runInput, writer->file);
+  writer->runLength = 0;
+}
+
+void ReplayWriterAppend(ReplayWriter *writer, SimInput input) {
+  if (writer->runLength > 0 && input != writer->runInput)
+    FlushRun(writer);
+  writer->runInput = input;
+  writer->runLength++;
+  writer->steps++;
+}
+
+bool ReplayWriterClose(ReplayWriter *writer, const GameState *final) {
+  FlushRun(writer);
+  uint8_t end[16];
+  PutLE(end, writer->steps, 8);
+  PutLE(end + 8, SimHash(final), 8);
+  PutVarint(writer->file, 0);
+  fwrite(end, 1, sizeof(end), writer->file);
+  bool ok = !ferror(writer->file);
+  ok = fclose(writer->file) == 0 && ok;
+  free(writer);
+  return ok;
+}
+
+static bool MapFile(ReplayReader *reader, const char *path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER size;
+  HANDLE mapping = NULL;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return false;
+  reader->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  reader->size = (size_t)size.QuadPart;
+  reader->mapping = mapping;
+  if (!reader->data) {
+    CloseHandle(mapping);
+    return false;
+  }
+  return true;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  void *data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+  reader->data = data;
+  reader->size = (size_t)st.st_size;
+  return true;
+#endif
+}
+
+bool ReplayReaderOpen(ReplayReader *reader, const char *path) {
+  memset(reader, 0, sizeof(*reader));
+  if (!MapFile(reader, path))
+    return false;
+
+  const uint8_t *p = reader->data;
+  if (reader->size < REPLAY_HEADER_SIZE || memcmp(p, REPLAY_MAGIC, 4) != 0 ||
+      GetLE(p + 4, 2) != REPLAY_VERSION) {
+    ReplayReaderClose(reader);
+    return false;
+  }
+  reader->header.seed = GetLE(p + 8, 8);
+  reader->header.screenWidth = BitsFloat((uint32_t)GetLE(p + 16, 4));
+  reader->header.screenHeight = BitsFloat((uint32_t)GetLE(p + 20, 4));
+  reader->header.swarmObstacles = (int32_t)GetLE(p + 24, 4);
+  reader->pos = REPLAY_HEADER_SIZE;
+  return true;
+}
+
+void ReplayReaderClose(ReplayReader *reader) {
+  if (reader->data) {
+#ifdef _WIN32
+    UnmapViewOfFile(reader->data);
+    CloseHandle(reader->mapping);
+#else
+    munmap((void *)reader->data, reader->size);
+#endif
+  }
+  memset(reader, 0, sizeof(*reader));
+}
+
+bool ReplayReaderNext(ReplayReader *reader, SimInput *input) {
+  while (reader->runLeft == 0) {
+    uint64_t length;
+    if (reader->hasEnd || !GetVarint(reader, &length))
+      return false;
+    if (length == 0) {
+      if (reader->size - reader->pos < 16)
+        return false;
+      reader->endSteps = GetLE(reader->data + reader->pos, 8);
+      reader->endHash = GetLE(reader->data + reader->pos + 8, 8);
+      reader->pos += 16;
+      reader->hasEnd = true;
+      return false;
+    }
+    if (reader->pos >= reader->size)
+      return false;
+    reader->runInput = reader->data[reader->pos++];
+    reader->runLeft = length;
+  }
+  reader->runLeft--;
+  reader->steps++;
+  *input = reader->runInput;
+  return true;
+}
+
+bool ReplayInitGame(const ReplayHeader *header, GameState *state) {
+  if (header->swarmObstacles > 0)
+    return SimInitSwarm(state, header->screenWidth, header->screenHeight,
+                        header->seed, header->swarmObstacles);
+  return SimInit(state, header->screenWidth, header->screenHeight,
+                 header->seed);
+}
@@ -0,0 +1,495 @@
+#include "rewind.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORD_FULL 1
+#define RECORD_DELTA 2
+// Nothing more before the end of the ring, the next record is at 0
+#define RECORD_WRAP 3
+
+typedef struct {
+  uint64_t step;
+  uint32_t size;         // payload bytes
+  uint32_t snapshotSize; // decoded
+  uint32_t type;
+  uint32_t reserved;
+} RecordHeader;
+
+#define MAX_VARINT 10
+
+static size_t RecordBytes(size_t payload) {
+  return (sizeof(RecordHeader) + payload + 7) & ~(size_t)7;
+}
+
+static RecordHeader *Record(const RewindBuffer *rewind, size_t offset) {
+  return (RecordHeader *)(rewind->ring + offset);
+}
+
+static const RewindKeyframe *Keyframe(const RewindBuffer *rewind, int group) {
+  return &rewind->keyframes[(rewind->firstKeyframe + group) %
+                            rewind->keyframeCapacity];
+}
+
+static bool GrowSnapshot(SimSnapshot *snapshot, size_t size) {
+  if (size <= snapshot->capacity)
+    return true;
+  uint8_t *data = realloc(snapshot->data, size);
+  if (!data)
+    return false;
+  snapshot->data = data;
+  snapshot->capacity = size;
+  return true;
+}
+
+static bool GrowScratch(RewindBuffer *rewind, size_t size) {
+  if (size <= rewind->scratchCapacity)
+    return true;
+  uint8_t *scratch = realloc(rewind->scratch, size);
+  if (!scratch)
+    return false;
+  rewind->scratch = scratch;
+  uint8_t *encoded = realloc(rewind->encoded, size);
+  if (!encoded)
+    return false;
+  rewind->encoded = encoded;
+  rewind->scratchCapacity = size;
+  return true;
+}
+
+bool RewindInit(RewindBuffer *rewind, size_t budgetBytes,
+                int keyframeInterval) {
+  memset(rewind, 0, sizeof(*rewind));
+  // Every group holds at least a keyframe, so the index never needs more
+  // entries than this
+  size_t minGroup = RecordBytes(sizeof(GameState));
+  size_t capacity = budgetBytes / (minGroup + sizeof(RewindKeyframe)) + 2;
+  size_t indexBytes = capacity * sizeof(RewindKeyframe);
+  if (budgetBytes < indexBytes + minGroup || capacity > INT32_MAX)
+    return false;
+
+  rewind->ringSize = (budgetBytes - indexBytes) & ~(size_t)7;
+  rewind->ring = malloc(rewind->ringSize);
+  rewind->keyframes = malloc(indexBytes);
+  if (!rewind->ring || !rewind->keyframes) {
+    RewindFree(rewind);
+    return false;
+  }
+  rewind->keyframeCapacity = (int)capacity;
+  rewind->keyframeInterval =
+      keyframeInterval > 0 ? keyframeInterval : REWIND_KEYFRAME_INTERVAL;
+  rewind->budget = budgetBytes;
+  return true;
+}
+
+void RewindFree(RewindBuffer *rewind) {
+  free(rewind->ring);
+  free(rewind->keyframes);
+  SimSnapshotFree(&rewind->previous);
+  SimSnapshotFree(&rewind->current);
+  SimSnapshotFree(&rewind->decoded);
+  SimSnapshotFree(&rewind->decodeSwap);
+  free(rewind->scratch);
+  free(rewind->encoded);
+  memset(rewind, 0, sizeof(*rewind));
+}
+
+void RewindClear(RewindBuffer *rewind) {
+  rewind->head = 0;
+  rewind->tail = 0;
+  rewind->used = 0;
+  rewind->firstKeyframe = 0;
+  rewind->keyframeCount = 0;
+  rewind->decodedValid = false;
+}
+
+// Drops the oldest group: its keyframe and every delta up to the next one
+static void EvictOldest(RewindBuffer *rewind) {
+  rewind->firstKeyframe =
+      (rewind->firstKeyframe + 1) % rewind->keyframeCapacity;
+  if (--rewind->keyframeCount == 0) {
+    RewindClear(rewind);
+    return;
+  }
+  const RewindKeyframe *next = Keyframe(rewind, 0);
+  size_t freed = next->offset > rewind->tail
+                     ? next->offset - rewind->tail
+                     : rewind->ringSize - rewind->tail + next->offset;
+  rewind->used -= freed;
+  rewind->tail = next->offset;
+  rewind->oldestStep = next->step;
+}
+
+// Finds room for a record at head, evicting old groups but keeping the
+// newest keepGroups. Returns its offset, or SIZE_MAX.
+static size_t Reserve(RewindBuffer *rewind, size_t bytes, int keepGroups) {
+  if (bytes > rewind->ringSize)
+    return SIZE_MAX;
+  for (;;) {
+    if (rewind->used == 0) {
+      rewind->head = 0;
+      rewind->tail = 0;
+      return 0;
+    }
+    if (rewind->head > rewind->tail) {
+      size_t end = rewind->ringSize - rewind->head;
+      if (bytes <= end)
+        return rewind->head;
+      // Records don't wrap, skip the end of the ring
+      if (end >= sizeof(RecordHeader))
+        Record(rewind, rewind->head)->type = RECORD_WRAP;
+      rewind->used += end;
+      rewind->head = 0;
+      continue;
+    }
+    // Full when head has caught up with tail
+    if (rewind->tail - rewind->head >= bytes)
+      return rewind->head;
+    if (rewind->keyframeCount <= keepGroups)
+      return SIZE_MAX;
+    EvictOldest(rewind);
+  }
+}
+
+static size_t NextRecord(const RewindBuffer *rewind, size_t offset) {
+  size_t next = offset + RecordBytes(Record(rewind, offset)->size);
+  if (next + sizeof(RecordHeader) > rewind->ringSize ||
+      Record(rewind, next)->type == RECORD_WRAP)
+    return 0;
+  return next;
+}
+
+// The XOR of cur against prev, section by section, with the bytes of each
+// float array split into planes (all the low bytes, then the next...), so
+// the bytes that rarely change end up in long zero runs. Past the end of a
+// previous section cur is XORed against zeros.
+static void XorPlanes(uint8_t *out, const uint8_t *cur, const uint8_t *prev) {
+  SimSnapshotSection curSections[SIM_SNAPSHOT_SECTIONS];
+  SimSnapshotSection prevSections[SIM_SNAPSHOT_SECTIONS];
+  SimSnapshotSections(cur, curSections);
+  SimSnapshotSections(prev, prevSections);
+  for (int s = 0; s < SIM_SNAPSHOT_SECTIONS; s++) {
+    int e = curSections[s].elementSize;
+    size_t n = curSections[s].size / e;
+    size_t common = prevSections[s].size / e;
+    if (common > n)
+      common = n;
+    const uint8_t *c = cur + curSections[s].offset;
+    const uint8_t *p = prev + prevSections[s].offset;
+    for (int b = 0; b < e; b++) {
+      uint8_t *plane = out + curSections[s].offset + b * n;
+      for (size_t i = 0; i < common; i++)
+        plane[i] = c[i * e + b] ^ p[i * e + b];
+      for (size_t i = common; i < n; i++)
+        plane[i] = c[i * e + b];
+    }
+  }
+}
+
+// Inverse of XorPlanes(). The GameState section comes first and gives the
+// layout of the rest.
+static void UnXorPlanes(uint8_t *cur, const uint8_t *in, const uint8_t *prev) {
+  for (size_t i = 0; i < sizeof(GameState); i++)
+    cur[i] = in[i] ^ prev[i];
+  SimSnapshotSection curSections[SIM_SNAPSHOT_SECTIONS];
+  SimSnapshotSection prevSections[SIM_SNAPSHOT_SECTIONS];
+  SimSnapshotSections(cur, curSections);
+  SimSnapshotSections(prev, prevSections);
+  for (int s = 1; s < SIM_SNAPSHOT_SECTIONS; s++) {
+    int e = curSections[s].elementSize;
+    size_t n = curSections[s].size / e;
+    size_t common = prevSections[s].size / e;
+    if (common > n)
+      common = n;
+    uint8_t *c = cur + curSections[s].offset;
+    const uint8_t *p = prev + prevSections[s].offset;
+    for (int b = 0; b < e; b++) {
+      const uint8_t *plane = in + curSections[s].offset + b * n;
+      for (size_t i = 0; i < common; i++)
+        c[i * e + b] = plane[i] ^ p[i * e + b];
+      for (size_t i = common; i < n; i++)
+        c[i * e + b] = plane[i];
+    }
+  }
+}
+
+static uint8_t *PutVarint(uint8_t *p, uint64_t v) {
+  do {
+    *p = v & 0x7F;
+    v >>= 7;
+    if (v)
+      *p |= 0x80;
+    p++;
+  } while (v);
+  return p;
+}
+
+static bool GetVarint(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+  *v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (*p >= end)
+      return false;
+    uint8_t byte = *(*p)++;
+    *v |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Pairs of varint zero count, varint literal count and the literals. Zero
+// runs under 3 bytes stay in the literals. Returns the encoded size, or
+// SIZE_MAX if it would be more than limit.
+static size_t EncodeZeroRuns(uint8_t *out, const uint8_t *in, size_t size,
+                             size_t limit) {
+  size_t written = 0;
+  size_t i = 0;
+  while (i < size) {
+    size_t start = i;
+    uint64_t word;
+    while (i + 8 <= size && (memcpy(&word, in + i, 8), word == 0))
+      i += 8;
+    while (i < size && in[i] == 0)
+      i++;
+    size_t zeros = i - start;
+
+    start = i;
+    while (i < size && !(in[i] == 0 && i + 2 < size && in[i + 1] == 0 &&
+                         in[i + 2] == 0))
+      i++;
+    size_t literal = i - start;
+
+    if (written + 2 * MAX_VARINT + literal > limit)
+      return SIZE_MAX;
+    uint8_t *p = PutVarint(out + written, zeros);
+    p = PutVarint(p, literal);
+    memcpy(p, in + start, literal);
+    written = (size_t)(p - out) + literal;
+  }
+  return written;
+}
+
+static bool DecodeZeroRuns(uint8_t *out, size_t size, const uint8_t *in,
+                           size_t inSize) {
+  const uint8_t *p = in;
+  const uint8_t *end = in + inSize;
+  size_t o = 0;
+  while (o < size) {
+    uint64_t zeros, literal;
+    if (!GetVarint(&p, end, &zeros) || !GetVarint(&p, end, &literal) ||
+        zeros > size - o || literal > size - o - zeros ||
+        literal > (uint64_t)(end - p))
+      return false;
+    memset(out + o, 0, zeros);
+    o += zeros;
+    memcpy(out + o, p, literal);
+    o += literal;
+    p += literal;
+  }
+  return true;
+}
+
+// Rebuilds the snapshot of the record at offset. Deltas apply to prev, the
+// snapshot of the step before.
+static bool DecodeRecord(RewindBuffer *rewind, size_t offset,
+                         const SimSnapshot *prev, SimSnapshot *out) {
+  const RecordHeader *header = Record(rewind, offset);
+  const uint8_t *payload = (const uint8_t *)(header + 1);
+  size_t size = header->snapshotSize;
+  if (!GrowSnapshot(out, size))
+    return false;
+  out->size = size;
+  if (header->type == RECORD_FULL) {
+    memcpy(out->data, payload, size);
+    return true;
+  }
+  if (header->type != RECORD_DELTA || !GrowScratch(rewind, size) ||
+      !DecodeZeroRuns(rewind->scratch, size, payload, header->size))
+    return false;
+  UnXorPlanes(out->data, rewind->scratch, prev->data);
+  return true;
+}
+
+bool RewindAppend(RewindBuffer *rewind, const GameState *state) {
+  if (!SimSnapshotSave(state, &rewind->current) ||
+      rewind->current.size > UINT32_MAX ||
+      !GrowScratch(rewind, rewind->current.size))
+    return false;
+
+  size_t size = rewind->current.size;
+  bool keyframe =
+      rewind->keyframeCount == 0 ||
+      rewind->nextStep - Keyframe(rewind, rewind->keyframeCount - 1)->step >=
+          (uint64_t)rewind->keyframeInterval;
+  const uint8_t *payload = rewind->current.data;
+  size_t payloadSize = size;
+  uint32_t type = RECORD_FULL;
+  if (!keyframe) {
+    XorPlanes(rewind->scratch, rewind->current.data, rewind->previous.data);
+    size_t encoded = EncodeZeroRuns(rewind->encoded, rewind->scratch, size,
+                                    size);
+    // Otherwise the delta stores the snapshot as is
+    if (encoded != SIZE_MAX) {
+      payload = rewind->encoded;
+      payloadSize = encoded;
+      type = RECORD_DELTA;
+    }
+  }
+
+  size_t bytes = RecordBytes(payloadSize);
+  size_t offset = keyframe ? SIZE_MAX : Reserve(rewind, bytes, 1);
+  if (offset == SIZE_MAX) {
+    // A new group may take the space of the whole history, including the
+    // group a delta didn't fit behind
+    keyframe = true;
+    payload = rewind->current.data;
+    payloadSize = size;
+    type = RECORD_FULL;
+    bytes = RecordBytes(size);
+    if (rewind->keyframeCount == rewind->keyframeCapacity)
+      EvictOldest(rewind);
+    offset = Reserve(rewind, bytes, 0);
+    if (offset == SIZE_MAX) {
+      RewindClear(rewind);
+      return false;
+    }
+  }
+
+  RecordHeader *header = Record(rewind, offset);
+  uint64_t step = rewind->nextStep++;
+  *header = (RecordHeader){step, (uint32_t)payloadSize,
+                           (uint32_t)size, type, 0};
+  memcpy(header + 1, payload, payloadSize);
+  rewind->head = offset + bytes;
+  rewind->used += bytes;
+  if (keyframe) {
+    int slot = (rewind->firstKeyframe + rewind->keyframeCount++) %
+               rewind->keyframeCapacity;
+    rewind->keyframes[slot] = (RewindKeyframe){step, offset};
+    rewind->keyframeBytes += bytes;
+    if (rewind->keyframeCount == 1)
+      rewind->oldestStep = step;
+  }
+  rewind->newestStep = step;
+  rewind->newestOffset = offset;
+
+  SimSnapshot swap = rewind->previous;
+  rewind->previous = rewind->current;
+  rewind->current = swap;
+
+  rewind->appended++;
+  rewind->appendedBytes += bytes;
+  rewind->snapshotBytes += RecordBytes(size);
+  return true;
+}
+
+bool RewindHas(const RewindBuffer *rewind, uint64_t step) {
+  return rewind->keyframeCount > 0 && step >= rewind->oldestStep &&
+         step <= rewind->newestStep;
+}
+
+// Last group whose keyframe is at or before step
+static int FindGroup(const RewindBuffer *rewind, uint64_t step) {
+  int low = 0;
+  int high = rewind->keyframeCount - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    if (Keyframe(rewind, mid)->step <= step)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+  return low;
+}
+
+// Decodes step into rewind->decoded
+static bool Decode(RewindBuffer *rewind, uint64_t step) {
+  if (!RewindHas(rewind, step))
+    return false;
+  if (step == rewind->newestStep) {
+    if (!SimSnapshotCopy(&rewind->decoded, &rewind->previous))
+      return false;
+    rewind->decodedStep = step;
+    rewind->decodedOffset = rewind->newestOffset;
+    rewind->decodedValid = true;
+    return true;
+  }
+
+  const RewindKeyframe *keyframe = Keyframe(rewind, FindGroup(rewind, step));
+  uint64_t t;
+  size_t offset;
+  if (rewind->decodedValid && rewind->decodedStep >= keyframe->step &&
+      rewind->decodedStep <= step) {
+    t = rewind->decodedStep;
+    offset = rewind->decodedOffset;
+  } else {
+    t = keyframe->step;
+    offset = keyframe->offset;
+    if (!DecodeRecord(rewind, offset, NULL, &rewind->decoded)) {
+      rewind->decodedValid = false;
+      return false;
+    }
+  }
+  while (t < step) {
+    offset = NextRecord(rewind, offset);
+    if (Record(rewind, offset)->step != t + 1 ||
+        !DecodeRecord(rewind, offset, &rewind->decoded,
+                      &rewind->decodeSwap)) {
+      rewind->decodedValid = false;
+      return false;
+    }
+    SimSnapshot swap = rewind->decoded;
+    rewind->decoded = rewind->decodeSwap;
+    rewind->decodeSwap = swap;
+    t++;
+  }
+  rewind->decodedStep = step;
+  rewind->decodedOffset = offset;
+  rewind->decodedValid = true;
+  return true;
+}
+
+bool RewindSeek(RewindBuffer *rewind, uint64_t step, GameState *state) {
+  return Decode(rewind, step) &&
+         SimSnapshotRestore(state, &rewind->decoded);
+}
+
+bool RewindTruncate(RewindBuffer *rewind, uint64_t step) {
+  if (step == rewind->newestStep && RewindHas(rewind, step))
+    return true;
+  if (!Decode(rewind, step) ||
+      !SimSnapshotCopy(&rewind->previous, &rewind->decoded))
+    return false;
+
+  rewind->keyframeCount = FindGroup(rewind, step) + 1;
+  size_t end = rewind->decodedOffset +
+               RecordBytes(Record(rewind, rewind->decodedOffset)->size);
+  rewind->used = end > rewind->tail
+                     ? end - rewind->tail
+                     : rewind->ringSize - rewind->tail + end;
+  rewind->head = end;
+  rewind->newestStep = step;
+  rewind->newestOffset = rewind->decodedOffset;
+  rewind->nextStep = step + 1;
+  return true;
+}
+
+RewindStats RewindGetStats(const RewindBuffer *rewind) {
+  RewindStats stats = {.bytesUsed = rewind->used, .budget = rewind->budget};
+  if (rewind->keyframeCount > 0) {
+    stats.oldestStep = rewind->oldestStep;
+    stats.newestStep = rewind->newestStep;
+    stats.steps = (int64_t)(rewind->newestStep - rewind->oldestStep + 1);
+    stats.seconds = (double)stats.steps / SIM_TICK_RATE;
+  }
+  if (rewind->appended > 0) {
+    stats.bytesPerSecond =
+        (double)rewind->appendedBytes / rewind->appended * SIM_TICK_RATE;
+    stats.secondsPerBudget = rewind->ringSize / stats.bytesPerSecond;
+    stats.compression =
+        (double)rewind->snapshotBytes / rewind->appendedBytes;
+    stats.keyframeShare =
+        (double)rewind->keyframeBytes / rewind->appendedBytes;
+  }
+  return stats;
+}
@@ -0,0 +1,93 @@
+#include "scene.h"
+
+void SceneRecord(RenderList *list, SceneHud *hud, const GameState *state,
+                 int highScore, RenderImage powerUpImage) {
+  SceneRecordInterpolated(list, hud, NULL, state, 1.0f, highScore,
+                          powerUpImage);
+}
+
+void SceneRecordInterpolated(RenderList *list, SceneHud *hud,
+                             const GameState *previous,
+                             const GameState *state, float alpha,
+                             int highScore, RenderImage powerUpImage) {
+  // Obstacle colors, indexed by GameObject.color, then the effect colors
+  const RenderColor palette[SIM_COLOR_COUNT] = {
+      RENDER_RED,       RENDER_DARKGRAY, RENDER_MAROON, RENDER_ORANGE,
+      RENDER_DARKGREEN, RENDER_GOLD,     RENDER_BLUE};
+
+  // Ticks (frames at 60 FPS) to move back from state. A restart resets the
+  // tick, game over stops it: nothing to blend then.
+  float back = 0.0f;
+  if (previous && previous->tick < state->tick)
+    back = (1.0f - alpha) * (float)(state->tick - previous->tick);
+
+  if (!state->gameOver) {
+    // Player (with invincibility color)
+    SimRect player = state->player.rect;
+    if (back > 0.0f) {
+      const SimRect *from = &previous->player.rect;
+      player.x = from->x + (player.x - from->x) * alpha;
+      player.y = from->y + (player.y - from->y) * alpha;
+    }
+    RenderRect(list, RENDER_LAYER_WORLD, player.x, player.y, player.width,
+               player.height,
+               state->isInvincible ? RENDER_YELLOW : RENDER_BLUE);
+
+    const ObstacleStore *obstacles = &state->obstacles;
+    for (int i = 0; i < obstacles->count; i++) {
+      RenderRect(list, RENDER_LAYER_WORLD, obstacles->x[i],
+                 obstacles->y[i] - obstacles->speed[i] * back, obstacles->w[i],
+                 obstacles->h[i], palette[obstacles->color[i]]);
+    }
+
+    for (int i = 0; i < MAX_POWERUPS; i++) {
+      const PowerUp *powerUp = &state->powerUps[i];
+      if (powerUp->active) {
+        RenderTexture(list, RENDER_LAYER_WORLD, powerUpImage,
+                      powerUp->rect.x, powerUp->rect.y, powerUp->rect.width,
+                      powerUp->rect.height, RENDER_WHITE);
+      }
+    }
+  }
+
+  // Effects go over the world, and outlive the run that made them
+  const ParticleStore *particles = &state->particles;
+  for (int i = 0; i < particles->count; i++) {
+    RenderCircle(list, RENDER_LAYER_EFFECTS,
+                 particles->x[i] - particles->vx[i] * back,
+                 particles->y[i] - particles->vy[i] * back,
+                 particles->radius[i],
+                 RenderFade(palette[particles->color[i]], particles->alpha[i]));
+  }
+
+  if (state->gameOver)
+    return;
+
+  // HUD, the strings are only formatted when their value changes
+  RenderText(list, RENDER_LAYER_HUD,
+             HudTextInt(&hud->score, "Score: %d", state->score), 10, 10, 20,
+             RENDER_BLACK);
+  RenderText(list, RENDER_LAYER_HUD,
+             HudTextInt(&hud->highScore, "High Score: %d", highScore), 10, 40,
+             20, RENDER_BLACK);
+  RenderText(list, RENDER_LAYER_HUD,
+             HudTextFloat(&hud->speed, "Speed: %.1f", state->baseSpeed, 1),
+             10, 70, 20, RENDER_BLACK);
+  RenderText(list, RENDER_LAYER_HUD,
+             HudTextInt(&hud->obstacles, "Obstacles: %d",
+                        state->obstacles.count),
+             10, 100, 20, RENDER_BLACK);
+  if (state->isInvincible) {
+    RenderText(list, RENDER_LAYER_HUD,
+               HudTextFloat(&hud->invincible, "Invincible: %.1f",
+                            state->invincibilityDuration -
+                                state->invincibilityTimer,
+                            1),
+               10, 130, 20, RENDER_GOLD);
+  }
+}
+
+int SceneHudRebuilds(const SceneHud *hud) {
+  return hud->score.rebuilds + hud->highScore.rebuilds + hud->speed.rebuilds +
+         hud->obstacles.rebuilds + hud->invincible.rebuilds;
+}
@@ -0,0 +1,627 @@
+#include "sim.h"
+
+#include "profiler.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// xorshift64*, seeded through splitmix64 so that small seeds still give
+// well mixed state
+static uint64_t NextRandom(uint64_t *rng) {
+  uint64_t x = *rng;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *rng = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t SeedRandom(uint64_t seed) {
+  uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return z ? z : 0x9E3779B97F4A7C15ULL; // xorshift state must not be 0
+}
+
+int SimRandomValue(GameState *state, int min, int max) {
+  if (min > max) {
+    int tmp = max;
+    max = min;
+    min = tmp;
+  }
+  uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+  return (int)(min + (int64_t)((NextRandom(&state->rng) >> 32) % range));
+}
+
+// Uniform in [min, max) from the effect stream
+static float EffectRandom(GameState *state, float min, float max) {
+  return min + (NextRandom(&state->effectRng) >> 40) / 16777216.0f *
+                   (max - min);
+}
+
+bool SimCheckCollision(SimRect a, SimRect b) {
+  return a.x < b.x + b.width && a.x + a.width > b.x && a.y < b.y + b.height &&
+         a.y + a.height > b.y;
+}
+
+// spawn a new obstacle with relative positioning
+static void SpawnObstacle(GameState *state, int i, float relativeX, float y) {
+  ObstacleStore *obstacles = &state->obstacles;
+  obstacles->x[i] = relativeX * state->screenWidth;
+  obstacles->y[i] = y;
+  obstacles->speed[i] =
+      state->baseSpeed + SimRandomValue(state, 0, 200) / 100.0f;
+  obstacles->color[i] = (uint8_t)SimRandomValue(state, 0, SIM_PALETTE_SIZE - 1);
+}
+
+// spawn a new power-up
+static void SpawnPowerUp(GameState *state, PowerUp *powerUp) {
+  powerUp->rect.width = 30;
+  powerUp->rect.height = 30;
+  powerUp->rect.x = SimRandomValue(
+      state, 50, (int)(state->screenWidth - 50 - powerUp->rect.width));
+  powerUp->rect.y = SimRandomValue(
+      state, 50, (int)(state->screenHeight - 200 - powerUp->rect.height));
+  powerUp->active = true;
+  powerUp->timer = 0.0f;
+  powerUp->duration = 5.0f; // Example duration
+  powerUp->type = 0;        // Invincibility
+}
+
+static void RespawnObstacle(GameState *state, int i) {
+  float relativeX = SimRandomValue(state, 0, 100) / 100.0f;
+  SpawnObstacle(state, i, relativeX, -state->obstacles.h[i]);
+}
+
+static int AddObstacle(GameState *state, float y) {
+  float size = state->obstacleSize;
+  int i = ObstacleStorePush(&state->obstacles, 0, y, size, size, 0, 0);
+  if (i < 0)
+    return -1;
+  float relativeX = SimRandomValue(state, 0, 100) / 100.0f;
+  SpawnObstacle(state, i, relativeX, y);
+  return i;
+}
+
+int SimSpawnObstacle(GameState *state) {
+  if (state->obstacles.count >= state->maxObstacles)
+    return -1;
+  return AddObstacle(state, -state->obstacleSize);
+}
+
+int SimSpawnPowerUp(GameState *state) {
+  for (int i = 0; i < MAX_POWERUPS; i++) {
+    if (!state->powerUps[i].active) {
+      PowerUp *powerUp = &state->powerUps[i];
+      SpawnPowerUp(state, powerUp);
+      BroadphaseSet(&state->powerUpGrid, i, powerUp->rect.x, powerUp->rect.y,
+                    powerUp->rect.width, powerUp->rect.height);
+      return i;
+    }
+  }
+  return -1;
+}
+
+static bool InitWithConfig(GameState *state, float screenWidth,
+                           float screenHeight, uint64_t seed,
+                           int initialObstacles, int maxObstacles,
+                           float obstacleSize) {
+  memset(state, 0, sizeof(*state));
+  if (!ObstacleStoreInit(&state->obstacles, maxObstacles) ||
+      !ParticleStoreInit(&state->particles, 256) ||
+      !BroadphaseInit(&state->obstacleGrid, 64.0f, maxObstacles) ||
+      !BroadphaseInit(&state->powerUpGrid, 64.0f, MAX_POWERUPS)) {
+    SimFree(state);
+    return false;
+  }
+  state->screenWidth = screenWidth;
+  state->screenHeight = screenHeight;
+  state->rng = SeedRandom(seed);
+  state->effectRng = SeedRandom(~seed);
+  state->initialObstacles = initialObstacles;
+  state->maxObstacles = maxObstacles;
+  state->obstacleSize = obstacleSize;
+
+  state->player = (GameObject){
+      .rect = {0.5f * screenWidth - 15, 0.8f * screenHeight, 30, 30},
+      .speed = {5.0f, 5.0f},
+      .active = true};
+
+  for (int i = 0; i < MAX_POWERUPS; i++) {
+    state->powerUps[i].rect = (SimRect){0, 0, 30, 30};
+  }
+
+  state->invincibilityDuration = 5.0f;
+  state->powerUpSpawnInterval = 10.0f;
+  state->startSpeed = 3.0f;
+  state->speedRampScore = 1000.0f;
+  state->obstacleScoreStep = 500;
+  SimReset(state);
+  return true;
+}
+
+bool SimInit(GameState *state, float screenWidth, float screenHeight,
+             uint64_t seed) {
+  return InitWithConfig(state, screenWidth, screenHeight, seed,
+                        INITIAL_OBSTACLES, MAX_OBSTACLES, 30.0f);
+}
+
+bool SimInitSwarm(GameState *state, float screenWidth, float screenHeight,
+                  uint64_t seed, int obstacleCount) {
+  return InitWithConfig(state, screenWidth, screenHeight, seed, obstacleCount,
+                        obstacleCount, SIM_SWARM_OBSTACLE_SIZE);
+}
+
+void SimFree(GameState *state) {
+  ObstacleStoreFree(&state->obstacles);
+  ParticleStoreFree(&state->particles);
+  BroadphaseFree(&state->obstacleGrid);
+  BroadphaseFree(&state->powerUpGrid);
+}
+
+void SimReset(GameState *state) {
+  // Reset player to relative position
+  state->player.rect.x = 0.5f * state->screenWidth - 15;
+  state->player.rect.y = 0.8f * state->screenHeight;
+  state->isInvincible = false;
+  state->invincibilityTimer = 0.0f;
+
+  // Reset game state
+  state->score = 0;
+  state->timePlayed = 0.0f;
+  state->baseSpeed = state->startSpeed;
+  state->nextObstacleScore = state->obstacleScoreStep;
+  state->gameOver = false;
+
+  // Reset the obstacles. A big field starts spread out above the screen
+  // instead of as one solid wall.
+  state->obstacles.count = 0;
+  BroadphaseClear(&state->obstacleGrid);
+  for (int i = 0; i < state->initialObstacles; i++) {
+    float y = -state->obstacleSize;
+    if (state->initialObstacles > MAX_OBSTACLES)
+      y -= SimRandomValue(state, 0, (int)state->screenHeight * 2);
+    AddObstacle(state, y);
+  }
+
+  // Reset the effects
+  state->particles.count = 0;
+
+  // Reset power-ups
+  for (int i = 0; i < MAX_POWERUPS; i++) {
+    state->powerUps[i].active = false;
+  }
+  BroadphaseClear(&state->powerUpGrid);
+  state->powerUpSpawnTimer = 0.0f;
+}
+
+void SimResize(GameState *state, float screenWidth, float screenHeight) {
+  state->screenWidth = screenWidth;
+  state->screenHeight = screenHeight;
+  // Adjust player position relative to new screen size
+  state->player.rect.y = 0.8f * screenHeight;
+}
+
+// Bytes per obstacle and per particle in a snapshot: their float arrays
+// followed by the color
+#define SNAPSHOT_OBSTACLE_FLOATS 5
+#define SNAPSHOT_PARTICLE_FLOATS 8
+#define SNAPSHOT_OBSTACLE_BYTES                                                \
+  (SNAPSHOT_OBSTACLE_FLOATS * sizeof(float) + sizeof(uint8_t))
+#define SNAPSHOT_PARTICLE_BYTES                                                \
+  (SNAPSHOT_PARTICLE_FLOATS * sizeof(float) + sizeof(uint8_t))
+
+static bool ReserveSnapshot(SimSnapshot *snapshot, size_t size) {
+  if (size <= snapshot->capacity)
+    return true;
+  uint8_t *data = realloc(snapshot->data, size);
+  if (!data)
+    return false;
+  snapshot->data = data;
+  snapshot->capacity = size;
+  return true;
+}
+
+static uint8_t *PackArrays(uint8_t *p, float *const arrays[], int arrayCount,
+                           const uint8_t *color, size_t n) {
+  for (int a = 0; a < arrayCount; a++) {
+    memcpy(p, arrays[a], n * sizeof(float));
+    p += n * sizeof(float);
+  }
+  memcpy(p, color, n);
+  return p + n;
+}
+
+static const uint8_t *UnpackArrays(const uint8_t *p, float *const arrays[],
+                                   int arrayCount, uint8_t *color, size_t n) {
+  for (int a = 0; a < arrayCount; a++) {
+    memcpy(arrays[a], p, n * sizeof(float));
+    p += n * sizeof(float);
+  }
+  memcpy(color, p, n);
+  return p + n;
+}
+
+bool SimSnapshotSave(const GameState *state, SimSnapshot *snapshot) {
+  const ObstacleStore *obstacles = &state->obstacles;
+  const ParticleStore *particles = &state->particles;
+  size_t n = (size_t)obstacles->count;
+  size_t m = (size_t)particles->count;
+  if (!ReserveSnapshot(snapshot, sizeof(GameState) +
+                                     n * SNAPSHOT_OBSTACLE_BYTES +
+                                     m * SNAPSHOT_PARTICLE_BYTES))
+    return false;
+
+  uint8_t *p = snapshot->data;
+  memcpy(p, state, sizeof(GameState));
+  p += sizeof(GameState);
+  float *const obstacleArrays[SNAPSHOT_OBSTACLE_FLOATS] = {
+      obstacles->x, obstacles->y, obstacles->w, obstacles->h,
+      obstacles->speed};
+  p = PackArrays(p, obstacleArrays, SNAPSHOT_OBSTACLE_FLOATS,
+                 obstacles->color, n);
+  float *const particleArrays[SNAPSHOT_PARTICLE_FLOATS] = {
+      particles->x,      particles->y,     particles->vx,
+      particles->vy,     particles->radius, particles->growth,
+      particles->alpha,  particles->fade};
+  p = PackArrays(p, particleArrays, SNAPSHOT_PARTICLE_FLOATS,
+                 particles->color, m);
+  snapshot->size = (size_t)(p - snapshot->data);
+  return true;
+}
+
+bool SimSnapshotRestore(GameState *state, const SimSnapshot *snapshot) {
+  // Keep our own allocations, the snapshot's pointers belong to the state
+  // it was taken from
+  ObstacleStore obstacles = state->obstacles;
+  ParticleStore particles = state->particles;
+  Broadphase obstacleGrid = state->obstacleGrid;
+  Broadphase powerUpGrid = state->powerUpGrid;
+  const uint8_t *p = snapshot->data;
+  memcpy(state, p, sizeof(GameState));
+  p += sizeof(GameState);
+  int obstacleCount = state->obstacles.count;
+  int particleCount = state->particles.count;
+  state->obstacles = obstacles;
+  state->particles = particles;
+  state->obstacleGrid = obstacleGrid;
+  state->powerUpGrid = powerUpGrid;
+
+  ObstacleStore *store = &state->obstacles;
+  ParticleStore *effects = &state->particles;
+  if (!ObstacleStoreReserve(store, obstacleCount) ||
+      !ParticleStoreReserve(effects, particleCount))
+    return false;
+  store->count = obstacleCount;
+  effects->count = particleCount;
+  float *const obstacleArrays[SNAPSHOT_OBSTACLE_FLOATS] = {
+      store->x, store->y, store->w, store->h, store->speed};
+  p = UnpackArrays(p, obstacleArrays, SNAPSHOT_OBSTACLE_FLOATS, store->color,
+                   (size_t)obstacleCount);
+  float *const particleArrays[SNAPSHOT_PARTICLE_FLOATS] = {
+      effects->x,     effects->y,      effects->vx,
+      effects->vy,    effects->radius, effects->growth,
+      effects->alpha, effects->fade};
+  UnpackArrays(p, particleArrays, SNAPSHOT_PARTICLE_FLOATS, effects->color,
+               (size_t)particleCount);
+
+  // Rebuild the broadphases
+  BroadphaseClear(&state->obstacleGrid);
+  if (!BroadphaseSetMany(&state->obstacleGrid, 0, obstacleCount, store->x,
+                         store->y, store->w, store->h))
+    return false;
+  BroadphaseClear(&state->powerUpGrid);
+  for (int i = 0; i < MAX_POWERUPS; i++) {
+    const PowerUp *powerUp = &state->powerUps[i];
+    if (powerUp->active)
+      BroadphaseSet(&state->powerUpGrid, i, powerUp->rect.x, powerUp->rect.y,
+                    powerUp->rect.width, powerUp->rect.height);
+  }
+  return true;
+}
+
+bool SimSnapshotCopy(SimSnapshot *dst, const SimSnapshot *src) {
+  if (!ReserveSnapshot(dst, src->size))
+    return false;
+  memcpy(dst->data, src->data, src->size);
+  dst->size = src->size;
+  return true;
+}
+
+void SimSnapshotFree(SimSnapshot *snapshot) {
+  free(snapshot->data);
+  memset(snapshot, 0, sizeof(*snapshot));
+}
+
+void SimSnapshotSections(const uint8_t *data,
+                         SimSnapshotSection sections[SIM_SNAPSHOT_SECTIONS]) {
+  int obstacleCount, particleCount;
+  memcpy(&obstacleCount,
+         data + offsetof(GameState, obstacles) + offsetof(ObstacleStore, count),
+         sizeof(int));
+  memcpy(&particleCount,
+         data + offsetof(GameState, particles) + offsetof(ParticleStore, count),
+         sizeof(int));
+
+  // Same order as SimSnapshotSave()
+  int s = 0;
+  size_t offset = 0;
+  sections[s++] = (SimSnapshotSection){offset, sizeof(GameState), 1};
+  offset += sizeof(GameState);
+  const int counts[2] = {obstacleCount, particleCount};
+  const int floats[2] = {SNAPSHOT_OBSTACLE_FLOATS, SNAPSHOT_PARTICLE_FLOATS};
+  for (int store = 0; store < 2; store++) {
+    size_t n = (size_t)counts[store];
+    for (int a = 0; a < floats[store]; a++) {
+      sections[s++] = (SimSnapshotSection){offset, n * sizeof(float), 4};
+      offset += n * sizeof(float);
+    }
+    sections[s++] = (SimSnapshotSection){offset, n, 1};
+    offset += n;
+  }
+}
+
+static void UpdatePlayer(GameState *state, SimInput input, float frames) {
+  GameObject *player = &state->player;
+  float moveSpeed = player->speed.x * (state->screenWidth / 800.0f) * frames;
+  if ((input & SIM_INPUT_RIGHT) &&
+      (player->rect.x + player->rect.width) < state->screenWidth)
+    player->rect.x += moveSpeed;
+  if ((input & SIM_INPUT_LEFT) && player->rect.x > 0)
+    player->rect.x -= moveSpeed;
+  if ((input & SIM_INPUT_UP) && player->rect.y > 0)
+    player->rect.y -= moveSpeed;
+  if ((input & SIM_INPUT_DOWN) &&
+      (player->rect.y + player->rect.height) < state->screenHeight)
+    player->rect.y += moveSpeed;
+}
+
+// What each emitter sends out. Speeds are in pixels per 60 FPS frame,
+// sparks leave at evenly spaced angles, debris at random ones.
+typedef struct {
+  int count;
+  float radius;
+  float growth;
+  float fade;
+  float minSpeed;
+  float maxSpeed;
+  bool evenAngles;
+} EffectShape;
+
+static const EffectShape effectShapes[SIM_EFFECT_COUNT] = {
+    [SIM_EFFECT_FLOOR_HIT] = {1, 10.0f, 5.0f, 0.05f, 0.0f, 0.0f, false},
+    [SIM_EFFECT_POWERUP] = {24, 3.0f, 0.0f, 0.03f, 3.0f, 3.0f, true},
+    [SIM_EFFECT_COLLISION] = {64, 4.0f, -0.05f, 0.02f, 1.0f, 6.0f, false},
+};
+
+int SimEmitParticles(GameState *state, SimEffect effect, float x, float y,
+                     int color) {
+  const EffectShape *shape = &effectShapes[effect];
+  ParticleStore *particles = &state->particles;
+  int count = shape->count;
+  if (count > SIM_MAX_PARTICLES - particles->count)
+    count = SIM_MAX_PARTICLES - particles->count;
+  if (!ParticleStoreReserve(particles, particles->count + count))
+    return 0;
+
+  Particle particle = {.x = x,
+                       .y = y,
+                       .radius = shape->radius,
+                       .growth = shape->growth,
+                       .alpha = 1.0f,
+                       .fade = shape->fade,
+                       .color = (uint8_t)color};
+  for (int k = 0; k < count; k++) {
+    if (shape->maxSpeed > 0.0f) {
+      float angle = shape->evenAngles ? 6.2831853f * k / shape->count
+                                      : EffectRandom(state, 0.0f, 6.2831853f);
+      float speed = EffectRandom(state, shape->minSpeed, shape->maxSpeed);
+      particle.vx = cosf(angle) * speed;
+      particle.vy = sinf(angle) * speed;
+    }
+    ParticleStorePush(particles, &particle);
+  }
+  return count;
+}
+
+void SimUpdateParticles(GameState *state, float dt) {
+  ParticlesIntegrate(&state->particles, dt * SIM_TICK_RATE);
+  ParticlesExpire(&state->particles);
+}
+
+static void TriggerFloorHit(GameState *state, int i) {
+  const ObstacleStore *obstacles = &state->obstacles;
+  SimEmitParticles(state, SIM_EFFECT_FLOOR_HIT,
+                   obstacles->x[i] + obstacles->w[i] / 2, state->screenHeight,
+                   obstacles->color[i]);
+  state->events[SIM_EVENT_FLOOR_HIT]++;
+}
+
+void SimStep(GameState *state, SimInput input, float dt) {
+  memset(state->events, 0, sizeof(state->events));
+
+  // Effects keep playing on the game over screen
+  if (state->gameOver) {
+    if (input & SIM_INPUT_RESTART)
+      SimReset(state);
+    else
+      SimUpdateParticles(state, dt);
+    return;
+  }
+
+  // Movement constants are per 60 FPS frame
+  float frames = dt * SIM_TICK_RATE;
+  state->tick++;
+
+  // Update time and score
+  PROFILE_BEGIN(PROFILE_SPAWN);
+  state->timePlayed += dt;
+  state->score = (int)(state->timePlayed * 100);
+
+  // Increase the difficulty based on score
+  state->baseSpeed =
+      state->startSpeed + (state->score / state->speedRampScore);
+
+  // Add a new obstacle when score threshold is reached
+  if (state->score >= state->nextObstacleScore &&
+      state->obstacles.count < state->maxObstacles) {
+    state->nextObstacleScore += state->obstacleScoreStep;
+    SimSpawnObstacle(state);
+  }
+
+  // Power-up the spawning
+  state->powerUpSpawnTimer += dt;
+  if (state->powerUpSpawnTimer >= state->powerUpSpawnInterval) {
+    state->powerUpSpawnTimer = 0.0f;
+    SimSpawnPowerUp(state);
+  }
+  PROFILE_END(PROFILE_SPAWN);
+
+  PROFILE_BEGIN(PROFILE_INPUT);
+  UpdatePlayer(state, input, frames);
+  const SimRect *player = &state->player.rect;
+  PROFILE_END(PROFILE_INPUT);
+
+  // Update power-ups
+  PROFILE_BEGIN(PROFILE_POWERUPS);
+  int32_t touched[MAX_POWERUPS];
+  int pickups = BroadphaseQuery(&state->powerUpGrid, player->x, player->y,
+                                player->width, player->height, touched,
+                                MAX_POWERUPS);
+  for (int k = 0; k < pickups; k++) {
+    const SimRect *rect = &state->powerUps[touched[k]].rect;
+    SimEmitParticles(state, SIM_EFFECT_POWERUP, rect->x + rect->width / 2,
+                     rect->y + rect->height / 2, SIM_COLOR_POWERUP);
+    state->powerUps[touched[k]].active = false;
+    BroadphaseRemove(&state->powerUpGrid, touched[k]);
+    state->isInvincible = true;
+    state->invincibilityTimer = 0.0f;
+    state->events[SIM_EVENT_POWERUP]++;
+  }
+  PROFILE_END(PROFILE_POWERUPS);
+
+  // Handling invincibility
+  PROFILE_BEGIN(PROFILE_INVINCIBILITY);
+  if (state->isInvincible) {
+    state->invincibilityTimer += dt;
+    if (state->invincibilityTimer >= state->invincibilityDuration) {
+      state->isInvincible = false;
+    }
+  }
+  PROFILE_END(PROFILE_INVINCIBILITY);
+
+  // Updating the obstacles and handling the collisions
+  PROFILE_BEGIN(PROFILE_OBSTACLES);
+  ObstacleStore *obstacles = &state->obstacles;
+  ObstaclesIntegrate(obstacles, frames);
+
+  int fallen = ObstaclesFindBelow(obstacles, state->screenHeight);
+  for (int k = 0; k < fallen; k++) {
+    int i = obstacles->scratch[k];
+    TriggerFloorHit(state, i);
+    RespawnObstacle(state, i);
+  }
+
+  // Moves are incremental, only obstacles crossing a cell get relinked
+  BroadphaseSetMany(&state->obstacleGrid, 0, obstacles->count, obstacles->x,
+                    obstacles->y, obstacles->w, obstacles->h);
+  int32_t blocker;
+  if (!state->isInvincible &&
+      BroadphaseQuery(&state->obstacleGrid, player->x, player->y,
+                      player->width, player->height, &blocker, 1) > 0) {
+    state->gameOver = true;
+    state->events[SIM_EVENT_COLLISION]++;
+    SimEmitParticles(state, SIM_EFFECT_COLLISION,
+                     player->x + player->width / 2,
+                     player->y + player->height / 2, SIM_COLOR_PLAYER);
+  }
+  PROFILE_END(PROFILE_OBSTACLES);
+
+  // Updates the effects
+  PROFILE_BEGIN(PROFILE_PARTICLES);
+  SimUpdateParticles(state, dt);
+  PROFILE_END(PROFILE_PARTICLES);
+}
+
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+  const uint8_t *bytes = data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+#define HASH_FIELD(hash, field) HashBytes(hash, &(field), sizeof(field))
+
+static uint64_t HashRect(uint64_t hash, SimRect rect) {
+  hash = HASH_FIELD(hash, rect.x);
+  hash = HASH_FIELD(hash, rect.y);
+  hash = HASH_FIELD(hash, rect.width);
+  return HASH_FIELD(hash, rect.height);
+}
+
+uint64_t SimHash(const GameState *state) {
+  // Field by field, struct padding is not part of the state
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  hash = HASH_FIELD(hash, state->screenWidth);
+  hash = HASH_FIELD(hash, state->screenHeight);
+  hash = HASH_FIELD(hash, state->rng);
+  hash = HASH_FIELD(hash, state->tick);
+  hash = HashRect(hash, state->player.rect);
+
+  const ObstacleStore *obstacles = &state->obstacles;
+  size_t n = (size_t)obstacles->count;
+  hash = HASH_FIELD(hash, obstacles->count);
+  hash = HashBytes(hash, obstacles->x, n * sizeof(float));
+  hash = HashBytes(hash, obstacles->y, n * sizeof(float));
+  hash = HashBytes(hash, obstacles->w, n * sizeof(float));
+  hash = HashBytes(hash, obstacles->h, n * sizeof(float));
+  hash = HashBytes(hash, obstacles->speed, n * sizeof(float));
+  hash = HashBytes(hash, obstacles->color, n);
+
+  for (int i = 0; i < MAX_POWERUPS; i++) {
+    const PowerUp *powerUp = &state->powerUps[i];
+    hash = HASH_FIELD(hash, powerUp->active);
+    if (powerUp->active) {
+      hash = HashRect(hash, powerUp->rect);
+      hash = HASH_FIELD(hash, powerUp->timer);
+      hash = HASH_FIELD(hash, powerUp->duration);
+      hash = HASH_FIELD(hash, powerUp->type);
+    }
+  }
+  const ParticleStore *particles = &state->particles;
+  size_t m = (size_t)particles->count;
+  hash = HASH_FIELD(hash, state->effectRng);
+  hash = HASH_FIELD(hash, particles->count);
+  hash = HashBytes(hash, particles->x, m * sizeof(float));
+  hash = HashBytes(hash, particles->y, m * sizeof(float));
+  hash = HashBytes(hash, particles->vx, m * sizeof(float));
+  hash = HashBytes(hash, particles->vy, m * sizeof(float));
+  hash = HashBytes(hash, particles->radius, m * sizeof(float));
+  hash = HashBytes(hash, particles->growth, m * sizeof(float));
+  hash = HashBytes(hash, particles->alpha, m * sizeof(float));
+  hash = HashBytes(hash, particles->fade, m * sizeof(float));
+  hash = HashBytes(hash, particles->color, m);
+
+  hash = HASH_FIELD(hash, state->initialObstacles);
+  hash = HASH_FIELD(hash, state->maxObstacles);
+  hash = HASH_FIELD(hash, state->obstacleSize);
+  hash = HASH_FIELD(hash, state->startSpeed);
+  hash = HASH_FIELD(hash, state->speedRampScore);
+  hash = HASH_FIELD(hash, state->obstacleScoreStep);
+
+  hash = HASH_FIELD(hash, state->score);
+  hash = HASH_FIELD(hash, state->baseSpeed);
+  hash = HASH_FIELD(hash, state->gameOver);
+  hash = HASH_FIELD(hash, state->timePlayed);
+  hash = HASH_FIELD(hash, state->nextObstacleScore);
+  hash = HASH_FIELD(hash, state->isInvincible);
+  hash = HASH_FIELD(hash, state->invincibilityTimer);
+  hash = HASH_FIELD(hash, state->invincibilityDuration);
+  hash = HASH_FIELD(hash, state->powerUpSpawnTimer);
+  hash = HASH_FIELD(hash, state->powerUpSpawnInterval);
+  return hash;
+}
@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+#include "simthread.h"
+
+#include "profiler.h"
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TICK_NS (1000000000ull / SIM_TICK_RATE)
+
+// Set in the middle index while the slot it names hasn't been taken
+#define FRAME_FRESH 4u
+#define FRAME_SLOT 3u
+
+typedef struct {
+  SimSnapshot snapshot;
+  SimFrameInfo info;
+} SimFrame;
+
+struct SimThread {
+  pthread_t thread;
+  GameState *state;
+  SimInputQueue queue;
+  atomic_bool quit;
+  atomic_bool paused;
+
+  // Triple buffer. back, middle and front always name different slots: the
+  // sim thread writes back and swaps it with middle, the render thread
+  // swaps front with middle when middle is fresh.
+  SimFrame frames[3];
+  _Alignas(64) _Atomic uint32_t middle;
+  uint32_t back;  // sim thread
+  uint32_t front; // render thread
+  // Render thread only, events of taken frames that couldn't be restored
+  int untaken[SIM_EVENT_COUNT];
+
+  // Sim thread only
+  int unread[SIM_EVENT_COUNT]; // events of frames the render thread skipped
+  SimTiming jitter;
+  SimTimingStats jitterStats;
+};
+
+void SimInputQueueInit(SimInputQueue *queue) {
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+}
+
+bool SimInputQueuePush(SimInputQueue *queue, SimInputEvent event) {
+  uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+  if (head - tail == SIM_INPUT_QUEUE_SIZE)
+    return false;
+  queue->events[head % SIM_INPUT_QUEUE_SIZE] = event;
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return true;
+}
+
+bool SimInputQueuePop(SimInputQueue *queue, SimInputEvent *event) {
+  uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+  if (head == tail)
+    return false;
+  *event = queue->events[tail % SIM_INPUT_QUEUE_SIZE];
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+void SimTimingAdd(SimTiming *timing, double ms) {
+  timing->ms[timing->next] = (float)ms;
+  timing->next = (timing->next + 1) % SIM_TIMING_WINDOW;
+  if (timing->count < SIM_TIMING_WINDOW)
+    timing->count++;
+  timing->total++;
+}
+
+static int CompareFloat(const void *a, const void *b) {
+  float x = *(const float *)a, y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+SimTimingStats SimTimingGet(const SimTiming *timing) {
+  int n = timing->count;
+  if (n == 0)
+    return (SimTimingStats){0};
+  float sorted[SIM_TIMING_WINDOW];
+  memcpy(sorted, timing->ms, n * sizeof(float));
+  qsort(sorted, n, sizeof(float), CompareFloat);
+  return (SimTimingStats){sorted[(n - 1) / 2], sorted[(n - 1) * 99 / 100],
+                          sorted[n - 1], timing->total};
+}
+
+void SimTimingAddTick(SimTiming *jitter, uint64_t *lastTickNs,
+                      uint64_t nowNs) {
+  if (*lastTickNs)
+    SimTimingAdd(jitter, fabs((double)(nowNs - *lastTickNs) - TICK_NS) / 1e6);
+  *lastTickNs = nowNs;
+}
+
+// Hands the state to the render thread. If the frame it replaces in the
+// middle was never taken, its events are carried into the next one.
+static void Publish(SimThread *thread, uint64_t step, uint64_t tickNs,
+                    uint64_t inputNs) {
+  SimFrame *frame = &thread->frames[thread->back];
+  if (!SimSnapshotSave(thread->state, &frame->snapshot)) {
+    // Not published, its events go out with the next frame that is
+    for (int i = 0; i < SIM_EVENT_COUNT; i++)
+      thread->unread[i] += thread->state->events[i];
+    return;
+  }
+  frame->info.step = step;
+  frame->info.tickNs = tickNs;
+  frame->info.inputNs = inputNs;
+  frame->info.jitter = thread->jitterStats;
+  for (int i = 0; i < SIM_EVENT_COUNT; i++)
+    frame->info.events[i] = thread->unread[i] + thread->state->events[i];
+
+  uint32_t old = atomic_exchange_explicit(
+      &thread->middle, thread->back | FRAME_FRESH, memory_order_acq_rel);
+  thread->back = old & FRAME_SLOT;
+  for (int i = 0; i < SIM_EVENT_COUNT; i++)
+    thread->unread[i] =
+        old & FRAME_FRESH ? thread->frames[thread->back].info.events[i] : 0;
+}
+
+void SimSleepUntil(uint64_t ns) {
+  struct timespec deadline = {(time_t)(ns / 1000000000ull),
+                              (long)(ns % 1000000000ull)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) ==
+         EINTR)
+    ;
+}
+
+static void *SimThreadMain(void *arg) {
+  SimThread *thread = arg;
+  GameState *state = thread->state;
+  SimInput held = 0;
+  SimInput once = 0; // restart presses, for one tick
+  uint64_t inputNs = 0;
+  uint64_t step = 0;
+  uint64_t lastTickNs = 0;
+  uint64_t next = ProfilerNow() + TICK_NS;
+
+  while (!atomic_load_explicit(&thread->quit, memory_order_relaxed)) {
+    uint64_t now = ProfilerNow();
+    if (now < next) {
+      SimSleepUntil(next);
+      continue;
+    }
+    // After a long stall (a debugger, a suspended laptop) start over
+    // instead of running a burst of ticks
+    if (now - next > SIM_THREAD_MAX_LAG * TICK_NS)
+      next = now;
+
+    SimInputEvent event;
+    while (SimInputQueuePop(&thread->queue, &event)) {
+      held = event.input & ~SIM_INPUT_RESTART;
+      once |= event.input & SIM_INPUT_RESTART;
+      inputNs = event.timeNs;
+    }
+
+    if (atomic_load_explicit(&thread->paused, memory_order_relaxed) &&
+        !state->gameOver) {
+      lastTickNs = 0; // a pause isn't jitter
+    } else {
+      PROFILE_BEGIN(PROFILE_SIM);
+      SimStep(state, held | once, SIM_DT);
+      PROFILE_END(PROFILE_SIM);
+      once = 0;
+      step++;
+
+      SimTimingAddTick(&thread->jitter, &lastTickNs, now);
+      if (step % SIM_TICK_RATE == 0)
+        thread->jitterStats = SimTimingGet(&thread->jitter);
+      Publish(thread, step, next, inputNs);
+    }
+    next += TICK_NS;
+  }
+  return NULL;
+}
+
+SimThread *SimThreadStart(GameState *state) {
+  SimThread *thread = calloc(1, sizeof(SimThread));
+  if (!thread)
+    return NULL;
+  thread->state = state;
+  SimInputQueueInit(&thread->queue);
+  atomic_init(&thread->quit, false);
+  atomic_init(&thread->paused, false);
+  thread->back = 0;
+  atomic_init(&thread->middle, 1);
+  thread->front = 2;
+
+  // The start state, so the render thread has something from the first
+  // frame
+  Publish(thread, 0, ProfilerNow(), 0);
+  if (pthread_create(&thread->thread, NULL, SimThreadMain, thread) != 0) {
+    for (int i = 0; i < 3; i++)
+      SimSnapshotFree(&thread->frames[i].snapshot);
+    free(thread);
+    return NULL;
+  }
+  return thread;
+}
+
+void SimThreadStop(SimThread *thread) {
+  if (!thread)
+    return;
+  atomic_store_explicit(&thread->quit, true, memory_order_relaxed);
+  pthread_join(thread->thread, NULL);
+  for (int i = 0; i < 3; i++)
+    SimSnapshotFree(&thread->frames[i].snapshot);
+  free(thread);
+}
+
+bool SimThreadPush(SimThread *thread, SimInput input, uint64_t timeNs) {
+  return SimInputQueuePush(&thread->queue, (SimInputEvent){input, timeNs});
+}
+
+void SimThreadPause(SimThread *thread, bool paused) {
+  atomic_store_explicit(&thread->paused, paused, memory_order_relaxed);
+}
+
+bool SimThreadAcquire(SimThread *thread, GameState *state,
+                      SimFrameInfo *info) {
+  if (!(atomic_load_explicit(&thread->middle, memory_order_relaxed) &
+        FRAME_FRESH))
+    return false;
+  uint32_t old = atomic_exchange_explicit(&thread->middle, thread->front,
+                                          memory_order_acq_rel);
+  thread->front = old & FRAME_SLOT;
+  const SimFrame *frame = &thread->frames[thread->front];
+  if (!SimSnapshotRestore(state, &frame->snapshot)) {
+    for (int i = 0; i < SIM_EVENT_COUNT; i++)
+      thread->untaken[i] += frame->info.events[i];
+    return false;
+  }
+  *info = frame->info;
+  for (int i = 0; i < SIM_EVENT_COUNT; i++) {
+    info->events[i] += thread->untaken[i];
+    thread->untaken[i] = 0;
+  }
+  return true;
+}
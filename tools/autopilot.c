@@ -0,0 +1,63 @@
+#include "bot.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Plays games with the lookahead autopilot (one decision per tick) and with
+// the reflex bot on the same seeds, and reports rollout throughput.
+//
+// usage: raylibLearn_autopilot [games] [budget ms] [max seconds]
+
+int main(int argc, char **argv) {
+  int games = argc > 1 ? atoi(argv[1]) : 3;
+  double budgetMs = argc > 2 ? atof(argv[2]) : 2.0;
+  long long maxTicks =
+      (long long)((argc > 3 ? atof(argv[3]) : 120.0) * SIM_TICK_RATE);
+
+  Autopilot pilot;
+  if (!AutopilotInit(&pilot, 1)) {
+    fprintf(stderr, "Error allocating the autopilot\n");
+    return 1;
+  }
+
+  printf("%6s %12s %12s %14s\n", "seed", "reflex", "autopilot",
+         "rollouts/s");
+  double reflexTotal = 0, pilotTotal = 0, rateTotal = 0;
+  for (int g = 0; g < games; g++) {
+    uint64_t seed = 1000 + g;
+    GameState game;
+    int scores[2];
+    double rate = 0;
+    long long decisions = 0;
+    for (int player = 0; player < 2; player++) {
+      if (!SimInit(&game, 800, 600, seed)) {
+        fprintf(stderr, "Error allocating the game state\n");
+        return 1;
+      }
+      for (long long t = 0; t < maxTicks && !game.gameOver; t++) {
+        SimInput input = BotReflex(&game);
+        if (player == 1) {
+          input = AutopilotDecide(&pilot, &game, budgetMs);
+          rate += pilot.rolloutsPerSecond;
+          decisions++;
+        }
+        SimStep(&game, input, SIM_DT);
+      }
+      scores[player] = game.score;
+      SimFree(&game);
+    }
+    rate /= decisions > 0 ? decisions : 1;
+    printf("%6llu %12d %12d %14.0f\n", (unsigned long long)seed, scores[0],
+           scores[1], rate);
+    reflexTotal += scores[0];
+    pilotTotal += scores[1];
+    rateTotal += rate;
+  }
+  printf("%6s %12.0f %12.0f %14.0f\n", "mean", reflexTotal / games,
+         pilotTotal / games, rateTotal / games);
+  printf("(%d rollouts of %d ticks each fit a %.1f ms budget on average)\n",
+         (int)(rateTotal / games * budgetMs / 1000.0), AUTOPILOT_HORIZON,
+         budgetMs);
+
+  AutopilotFree(&pilot);
+  return 0;
+}
@@ -0,0 +1,244 @@
+#include "bot.h"
+#include "jobs.h"
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Plays many independent seeded games with the reflex bot across a
+// work-stealing pool, prints survival statistics and how throughput
+// scales from 1 thread up to --threads.
+//
+// usage: raylibLearn_batch [--games N] [--threads N] [--seed N]
+//                          [--max-seconds S] [--swarm N]
+//                          [--start-speed F] [--speed-ramp F]
+//                          [--obstacle-step N] [--powerup-interval F]
+
+#define HISTOGRAM_BINS 20
+
+typedef struct {
+  int games;
+  int maxThreads;
+  uint64_t seed;
+  long long maxTicks;
+  int swarm;
+  // Difficulty overrides, negative keeps the game's default
+  float startSpeed;
+  float speedRampScore;
+  int obstacleScoreStep;
+  float powerUpSpawnInterval;
+} BatchConfig;
+
+typedef struct {
+  const BatchConfig *config;
+  int *scores;
+  long long *ticks;
+} Batch;
+
+static double Now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Runs games [begin, end). Each game owns its GameState and with it its RNG,
+// so results don't depend on which worker ran it.
+static void PlayGames(void *ctx, int begin, int end, int worker) {
+  (void)worker;
+  Batch *batch = ctx;
+  const BatchConfig *config = batch->config;
+
+  for (int g = begin; g < end; g++) {
+    GameState game;
+    uint64_t seed = config->seed + (uint64_t)g;
+    bool ready = config->swarm > 0
+                     ? SimInitSwarm(&game, 800, 600, seed, config->swarm)
+                     : SimInit(&game, 800, 600, seed);
+    if (!ready) {
+      // Marks the game failed, main() refuses to report on the batch
+      batch->scores[g] = 0;
+      batch->ticks[g] = -1;
+      continue;
+    }
+    if (config->startSpeed >= 0)
+      game.startSpeed = config->startSpeed;
+    if (config->speedRampScore > 0)
+      game.speedRampScore = config->speedRampScore;
+    if (config->obstacleScoreStep > 0)
+      game.obstacleScoreStep = config->obstacleScoreStep;
+    if (config->powerUpSpawnInterval > 0)
+      game.powerUpSpawnInterval = config->powerUpSpawnInterval;
+    SimReset(&game);
+
+    long long t = 0;
+    while (!game.gameOver && t < config->maxTicks) {
+      SimStep(&game, BotReflex(&game), SIM_DT);
+      t++;
+    }
+    batch->scores[g] = game.score;
+    batch->ticks[g] = t;
+    SimFree(&game);
+  }
+}
+
+static int CompareInt(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+static bool PrintStatistics(const Batch *batch) {
+  int n = batch->config->games;
+  int *sorted = malloc(n * sizeof(int));
+  if (!sorted)
+    return false;
+  memcpy(sorted, batch->scores, n * sizeof(int));
+  qsort(sorted, n, sizeof(int), CompareInt);
+
+  double sum = 0;
+  int capped = 0;
+  for (int g = 0; g < n; g++) {
+    sum += batch->scores[g];
+    if (batch->ticks[g] >= batch->config->maxTicks)
+      capped++;
+  }
+  // Score is time played * 100
+  printf("survival (s): mean %.2f  p10 %.2f  median %.2f  p90 %.2f  max "
+         "%.2f\n",
+         sum / n / 100.0, sorted[n / 10] / 100.0, sorted[n / 2] / 100.0,
+         sorted[n * 9 / 10] / 100.0, sorted[n - 1] / 100.0);
+  if (capped)
+    printf("%d games hit the --max-seconds cap\n", capped);
+
+  int binWidth = sorted[n - 1] / HISTOGRAM_BINS + 1;
+  int bins[HISTOGRAM_BINS] = {0};
+  int tallest = 0;
+  for (int g = 0; g < n; g++) {
+    int bin = sorted[g] / binWidth;
+    if (++bins[bin] > tallest)
+      tallest = bins[bin];
+  }
+  printf("\nscore histogram\n");
+  for (int b = 0; b < HISTOGRAM_BINS; b++) {
+    int bar = tallest ? bins[b] * 50 / tallest : 0;
+    printf("%6d-%-6d %6d |", b * binWidth, (b + 1) * binWidth - 1, bins[b]);
+    for (int i = 0; i < bar; i++)
+      putchar('#');
+    putchar('\n');
+  }
+  free(sorted);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  BatchConfig config = {
+      .games = 2000,
+      .maxThreads = JobHardwareThreads(),
+      .seed = 1,
+      .maxTicks = 300LL * SIM_TICK_RATE,
+      .startSpeed = -1,
+      .speedRampScore = -1,
+      .obstacleScoreStep = -1,
+      .powerUpSpawnInterval = -1,
+  };
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const char *flag = argv[i];
+    const char *value = argv[i + 1];
+    if (strcmp(flag, "--games") == 0)
+      config.games = atoi(value);
+    else if (strcmp(flag, "--threads") == 0)
+      config.maxThreads = atoi(value);
+    else if (strcmp(flag, "--seed") == 0)
+      config.seed = strtoull(value, NULL, 10);
+    else if (strcmp(flag, "--max-seconds") == 0)
+      config.maxTicks = (long long)(atof(value) * SIM_TICK_RATE);
+    else if (strcmp(flag, "--swarm") == 0)
+      config.swarm = atoi(value);
+    else if (strcmp(flag, "--start-speed") == 0)
+      config.startSpeed = (float)atof(value);
+    else if (strcmp(flag, "--speed-ramp") == 0)
+      config.speedRampScore = (float)atof(value);
+    else if (strcmp(flag, "--obstacle-step") == 0)
+      config.obstacleScoreStep = atoi(value);
+    else if (strcmp(flag, "--powerup-interval") == 0)
+      config.powerUpSpawnInterval = (float)atof(value);
+    else {
+      fprintf(stderr, "unknown option %s\n", flag);
+      return 2;
+    }
+  }
+  if (config.games < 1 || config.maxThreads < 1) {
+    fprintf(stderr, "--games and --threads must be positive\n");
+    return 2;
+  }
+
+  Batch batch = {&config, calloc(config.games, sizeof(int)),
+                 calloc(config.games, sizeof(long long))};
+  if (!batch.scores || !batch.ticks) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  printf("%8s %12s %14s %9s\n", "threads", "games/s", "ticks/s", "speedup");
+  double baseRate = 0;
+  uint64_t firstChecksum = 0;
+  bool haveChecksum = false;
+  for (int threads = 1;; threads *= 2) {
+    if (threads > config.maxThreads)
+      threads = config.maxThreads;
+
+    JobPool *pool = JobPoolCreate(threads);
+    if (!pool) {
+      fprintf(stderr, "could not start %d threads\n", threads);
+      return 1;
+    }
+    double start = Now();
+    JobPoolRun(pool, config.games, 4, PlayGames, &batch);
+    double elapsed = Now() - start;
+    int workers = JobPoolWorkers(pool);
+    JobPoolDestroy(pool);
+
+    long long totalTicks = 0;
+    uint64_t checksum = 0; // wraps
+    int failed = 0;
+    for (int g = 0; g < config.games; g++) {
+      if (batch.ticks[g] < 0) {
+        failed++;
+        continue;
+      }
+      totalTicks += batch.ticks[g];
+      checksum = checksum * 31 + (uint64_t)batch.scores[g];
+    }
+    if (failed) {
+      fprintf(stderr, "%d games failed to start\n", failed);
+      return 1;
+    }
+    double rate = config.games / elapsed;
+    if (baseRate == 0)
+      baseRate = rate;
+    printf("%8d %12.0f %14.0f %8.2fx\n", workers, rate, totalTicks / elapsed,
+           rate / baseRate);
+
+    // Every game is seeded by its index, so the thread count must not
+    // change a single score
+    if (haveChecksum && checksum != firstChecksum) {
+      fprintf(stderr, "results differ between thread counts\n");
+      return 1;
+    }
+    firstChecksum = checksum;
+    haveChecksum = true;
+    if (threads == config.maxThreads)
+      break;
+  }
+
+  printf("\n%d games, seeds %llu..%llu\n", config.games,
+         (unsigned long long)config.seed,
+         (unsigned long long)(config.seed + config.games - 1));
+  bool printed = PrintStatistics(&batch);
+  free(batch.scores);
+  free(batch.ticks);
+  if (!printed) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Runs the simulation without a window and reports tick throughput.
+//
+// usage: raylibLearn_headless [ticks] [seed] [swarm obstacles]
+
+static double Now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+  long long ticks = argc > 1 ? atoll(argv[1]) : 10000000;
+  uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+
+  int swarm = argc > 3 ? atoi(argv[3]) : 0;
+
+  GameState game;
+  bool ready = swarm > 0 ? SimInitSwarm(&game, 800, 600, seed, swarm)
+                         : SimInit(&game, 800, 600, seed);
+  if (!ready) {
+    fprintf(stderr, "Error allocating the game state\n");
+    return 1;
+  }
+
+  long long games = 1;
+  long long bestScore = 0;
+  double start = Now();
+  for (long long t = 0; t < ticks; t++) {
+    // Sweep left and right, restart as soon as we die
+    SimInput input = ((t / 90) & 1) ? SIM_INPUT_LEFT : SIM_INPUT_RIGHT;
+    if (game.gameOver) {
+      if (game.score > bestScore)
+        bestScore = game.score;
+      input |= SIM_INPUT_RESTART;
+      games++;
+    }
+    SimStep(&game, input, SIM_DT);
+  }
+  double elapsed = Now() - start;
+
+  printf("ticks:      %lld\n", ticks);
+  printf("games:      %lld\n", games);
+  printf("best score: %lld\n", bestScore);
+  printf("elapsed:    %.3f s\n", elapsed);
+  printf("ticks/sec:  %.0f\n", ticks / (elapsed > 0 ? elapsed : 1e-9));
+  SimFree(&game);
+  return 0;
+}
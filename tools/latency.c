@@ -0,0 +1,238 @@
+#include "bot.h"
+#include "profiler.h"
+#include "render.h"
+#include "scene.h"
+#include "simthread.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Input-to-display latency and tick jitter of the game loop, stepping the
+// simulation on the render thread against stepping it on a SimThread, with
+// no window. A 60 FPS loop records and flushes the scene through the null
+// backend every frame, and about one frame in HICCUP_EVERY stalls for the
+// hiccup time (a texture upload, a disk write). Frames are presented on a
+// 60 Hz vsync, a frame that misses one waits for the next. The reflex bot
+// plays from the displayed state, so its inputs take the keyboard's path:
+// latency runs from sampling an input change to the present of the first
+// frame that shows a tick which used it.
+//
+// usage: raylibLearn_latency [seconds] [hiccup ms] [swarm obstacles] [seed]
+// (0 swarm obstacles plays classic mode)
+
+#define FRAME_NS (1000000000ull / 60)
+#define HICCUP_EVERY 20
+
+typedef struct {
+  RenderList list;
+  RenderNullCounts counts;
+  RenderBackend backend;
+  SceneHud hud;
+  uint64_t hiccupNs;
+} Frame;
+
+typedef struct {
+  SimTiming latency;
+  SimTimingStats jitter;
+  long long frames;
+  long long ticks;
+  double seconds;
+} LoopResult;
+
+static SimInput BotInput(const GameState *state) {
+  SimInput input = BotReflex(state);
+  if (state->gameOver)
+    input |= SIM_INPUT_RESTART;
+  return input;
+}
+
+// Records and flushes one frame, maybe stalls, then waits for the next
+// vsync after start. Returns the present time.
+static uint64_t DrawFrame(Frame *frame, uint64_t start,
+                          const GameState *previous, const GameState *state,
+                          float alpha) {
+  RenderBegin(&frame->list, RENDER_RAYWHITE);
+  SceneRecordInterpolated(&frame->list, &frame->hud, previous, state, alpha,
+                          0, (RenderImage){1, 64, 64});
+  RenderFlush(&frame->list, &frame->backend);
+  if (frame->hiccupNs && rand() % HICCUP_EVERY == 0)
+    SimSleepUntil(ProfilerNow() + frame->hiccupNs);
+  uint64_t vsyncs = (ProfilerNow() - start) / FRAME_NS + 1;
+  uint64_t present = start + vsyncs * FRAME_NS;
+  SimSleepUntil(present);
+  return present;
+}
+
+// The game's own loop: a fixed-step accumulator on the render thread
+static void RunLockstep(GameState *game, Frame *frame, uint64_t durationNs,
+                        LoopResult *result) {
+  SimTiming jitter = {0};
+  float accumulator = 0.0f;
+  SimInput lastInput = 0;
+  uint64_t changedNs = 0;  // input change not yet stepped
+  uint64_t consumedNs = 0; // stepped, not yet shown
+  uint64_t lastTickNs = 0;
+  uint64_t start = ProfilerNow();
+  uint64_t last = start;
+
+  while (ProfilerNow() - start < durationNs) {
+    uint64_t frameStart = ProfilerNow();
+    float deltaTime = (float)((frameStart - last) / 1e9);
+    last = frameStart;
+    if (deltaTime > SIM_MAX_FRAME_TIME)
+      deltaTime = SIM_MAX_FRAME_TIME;
+
+    SimInput input = BotInput(game);
+    if (input != lastInput) {
+      changedNs = frameStart;
+      lastInput = input;
+    }
+
+    accumulator += deltaTime;
+    while (accumulator >= SIM_DT) {
+      SimStep(game, input, SIM_DT);
+      accumulator -= SIM_DT;
+      result->ticks++;
+      SimTimingAddTick(&jitter, &lastTickNs, ProfilerNow());
+      if (changedNs) {
+        consumedNs = changedNs;
+        changedNs = 0;
+      }
+      input &= ~SIM_INPUT_RESTART;
+    }
+
+    uint64_t shown = DrawFrame(frame, start, NULL, game, 1.0f);
+    if (consumedNs) {
+      SimTimingAdd(&result->latency, (shown - consumedNs) / 1e6);
+      consumedNs = 0;
+    }
+    result->frames++;
+  }
+  result->jitter = SimTimingGet(&jitter);
+  result->seconds = (ProfilerNow() - start) / 1e9;
+}
+
+// The sim thread steps the game, the loop draws between the two newest
+// ticks it took
+static void RunThreaded(GameState *game, GameState views[2], Frame *frame,
+                        uint64_t durationNs, LoopResult *result) {
+  SimThread *thread = SimThreadStart(game);
+  if (!thread) {
+    fprintf(stderr, "Error starting the sim thread\n");
+    exit(1);
+  }
+  GameState *previous = &views[0];
+  GameState *current = &views[1];
+  SimFrameInfo previousInfo = {0};
+  SimFrameInfo currentInfo = {0};
+  int taken = 0;
+  SimInput lastInput = 0;
+  uint64_t restartStep = UINT64_MAX;
+  uint64_t shownInputNs = 0;
+  uint64_t start = ProfilerNow();
+
+  while (ProfilerNow() - start < durationNs) {
+    uint64_t frameStart = ProfilerNow();
+    SimFrameInfo info;
+    if (SimThreadAcquire(thread, previous, &info)) {
+      GameState *swap = previous;
+      previous = current;
+      current = swap;
+      previousInfo = currentInfo;
+      currentInfo = info;
+      taken++;
+    }
+
+    // A restart is pressed again if the game over screen outlives it
+    SimInput input = BotInput(current);
+    if (input != lastInput ||
+        (input & SIM_INPUT_RESTART && currentInfo.step != restartStep)) {
+      SimThreadPush(thread, input, frameStart);
+      lastInput = input;
+      if (input & SIM_INPUT_RESTART)
+        restartStep = currentInfo.step;
+    }
+
+    float alpha = 1.0f;
+    if (taken > 1 && currentInfo.tickNs > previousInfo.tickNs) {
+      alpha = (float)((double)(frameStart - currentInfo.tickNs) /
+                      (double)(currentInfo.tickNs - previousInfo.tickNs));
+      alpha = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+    }
+    uint64_t shown =
+        DrawFrame(frame, start, taken > 1 ? previous : NULL, current, alpha);
+    if (currentInfo.inputNs > shownInputNs) {
+      SimTimingAdd(&result->latency, (shown - currentInfo.inputNs) / 1e6);
+      shownInputNs = currentInfo.inputNs;
+    }
+    result->frames++;
+  }
+  SimThreadStop(thread);
+  result->ticks = (long long)currentInfo.step;
+  result->jitter = currentInfo.jitter;
+  result->seconds = (ProfilerNow() - start) / 1e9;
+}
+
+static void PrintResult(const char *mode, const LoopResult *result) {
+  SimTimingStats latency = SimTimingGet(&result->latency);
+  printf("%-9s %7lld %8.1f %7lld %8.2f %8.2f %8.2f %8.3f %8.3f %8.3f\n",
+         mode, result->frames, result->ticks / result->seconds,
+         latency.samples, latency.p50Ms, latency.p99Ms, latency.maxMs,
+         result->jitter.p50Ms, result->jitter.p99Ms, result->jitter.maxMs);
+}
+
+static bool InitGame(GameState *state, int swarm, uint64_t seed) {
+  return swarm > 0 ? SimInitSwarm(state, 800, 600, seed, swarm)
+                   : SimInit(state, 800, 600, seed);
+}
+
+int main(int argc, char **argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 10.0;
+  double hiccupMs = argc > 2 ? atof(argv[2]) : 40.0;
+  // Classic mode's few obstacles rarely make the bot change its input in
+  // the first seconds, a swarm keeps it dodging
+  int swarm = argc > 3 ? atoi(argv[3]) : SIM_SWARM_OBSTACLES;
+  uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+  if (seconds <= 0.0 || hiccupMs < 0.0) {
+    fprintf(stderr, "need a positive duration and hiccup time\n");
+    return 1;
+  }
+
+  Frame frame = {.hiccupNs = (uint64_t)(hiccupMs * 1e6)};
+  GameState lockstepGame, threadedGame, views[2];
+  if (!RenderListInit(&frame.list) || !InitGame(&lockstepGame, swarm, seed) ||
+      !InitGame(&threadedGame, swarm, seed) ||
+      !InitGame(&views[0], swarm, seed) || !InitGame(&views[1], swarm, seed)) {
+    fprintf(stderr, "Error allocating the game state\n");
+    return 1;
+  }
+  frame.backend = RenderNullBackend(&frame.counts);
+  uint64_t durationNs = (uint64_t)(seconds * 1e9);
+
+  printf("%.1f s per mode, %.0f ms stall every ~%d frames\n", seconds,
+         hiccupMs, HICCUP_EVERY);
+  printf("%-9s %7s %8s %7s %8s %8s %8s %8s %8s %8s\n", "", "", "", "",
+         "latency", "ms", "", "jitter", "ms", "");
+  printf("%-9s %7s %8s %7s %8s %8s %8s %8s %8s %8s\n", "mode", "frames",
+         "ticks/s", "inputs", "p50", "p99", "max", "p50", "p99", "max");
+
+  LoopResult lockstep = {0};
+  srand(1);
+  RunLockstep(&lockstepGame, &frame, durationNs, &lockstep);
+  PrintResult("lockstep", &lockstep);
+
+  LoopResult threaded = {0};
+  srand(1);
+  RunThreaded(&threadedGame, views, &frame, durationNs, &threaded);
+  PrintResult("threaded", &threaded);
+
+  RenderListFree(&frame.list);
+  SimFree(&lockstepGame);
+  SimFree(&threadedGame);
+  SimFree(&views[0]);
+  SimFree(&views[1]);
+  if (lockstep.latency.total == 0 || threaded.latency.total == 0) {
+    fprintf(stderr, "no input changes reached the screen, run longer\n");
+    return 1;
+  }
+  return 0;
+}
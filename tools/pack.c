@@ -0,0 +1,87 @@
+#include "bundle.h"
+#include "raylib.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Decodes resources with raylib and packs the results into one bundle, so
+// the game skips WAV/PNG decoding at startup. Anything that isn't audio or
+// an image is stored as-is.
+//
+// usage: raylibLearn_pack <bundle> <files...>
+
+static bool PackWave(BundleWriter *writer, const char *path) {
+  Wave wave = LoadWave(path);
+  if (!wave.data)
+    return false;
+  uint32_t meta[4] = {wave.frameCount, wave.sampleRate, wave.sampleSize,
+                      wave.channels};
+  size_t size =
+      (size_t)wave.frameCount * wave.channels * (wave.sampleSize / 8);
+  bool ok = BundleWriterAdd(writer, GetFileName(path), BUNDLE_WAVE, meta,
+                            wave.data, size);
+  UnloadWave(wave);
+  return ok;
+}
+
+static bool PackImage(BundleWriter *writer, const char *path) {
+  Image image = LoadImage(path);
+  if (!image.data)
+    return false;
+  uint32_t meta[4] = {(uint32_t)image.width, (uint32_t)image.height,
+                      (uint32_t)image.format, (uint32_t)image.mipmaps};
+  size_t size =
+      (size_t)GetPixelDataSize(image.width, image.height, image.format);
+  bool ok = BundleWriterAdd(writer, GetFileName(path), BUNDLE_IMAGE, meta,
+                            image.data, size);
+  UnloadImage(image);
+  return ok;
+}
+
+static bool PackRaw(BundleWriter *writer, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+  bool ok = false;
+  long size = -1;
+  if (fseek(file, 0, SEEK_END) == 0)
+    size = ftell(file);
+  void *data = size >= 0 ? malloc(size ? (size_t)size : 1) : NULL;
+  if (data && fseek(file, 0, SEEK_SET) == 0 &&
+      fread(data, 1, (size_t)size, file) == (size_t)size)
+    ok = BundleWriterAdd(writer, GetFileName(path), BUNDLE_RAW, NULL, data,
+                         (size_t)size);
+  free(data);
+  fclose(file);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <bundle> <files...>\n", argv[0]);
+    return 1;
+  }
+  SetTraceLogLevel(LOG_WARNING);
+
+  BundleWriter *writer = BundleWriterOpen(argv[1]);
+  if (!writer) {
+    fprintf(stderr, "Error allocating the bundle writer\n");
+    return 1;
+  }
+  bool ok = true;
+  for (int i = 2; ok && i < argc; i++) {
+    const char *path = argv[i];
+    if (IsFileExtension(path, ".wav;.ogg;.mp3;.flac;.qoa"))
+      ok = PackWave(writer, path);
+    else if (IsFileExtension(path, ".png;.bmp;.tga;.jpg;.gif;.qoi"))
+      ok = PackImage(writer, path);
+    else
+      ok = PackRaw(writer, path);
+    if (!ok)
+      fprintf(stderr, "Error packing %s\n", path);
+  }
+  if (!BundleWriterClose(writer) || !ok) {
+    fprintf(stderr, "Error writing %s\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,158 @@
+#include "bot.h"
+#include "profiler.h"
+#include "rewind.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Plays reflex bot games into a rewind buffer and reports what the history
+// costs: bytes per second of play, the seconds the budget holds,
+// compression against full snapshots, and append and seek times. Shows the
+// steps before the first collision, then checks every step still held:
+// seeking to it must give the SimHash() taken when it was appended, and so
+// must replaying the inputs after truncating the history halfway.
+//
+// usage: raylibLearn_rewind [ticks] [swarm obstacles] [budget MB] [seed]
+
+#define INSPECT_STEPS 6
+
+// Distance from the player to the closest obstacle edge
+static float NearestObstacle(const GameState *state) {
+  const SimRect *player = &state->player.rect;
+  const ObstacleStore *obstacles = &state->obstacles;
+  float nearest = INFINITY;
+  for (int i = 0; i < obstacles->count; i++) {
+    float dx = fmaxf(0.0f, fmaxf(obstacles->x[i] - (player->x + player->width),
+                                 player->x - (obstacles->x[i] +
+                                              obstacles->w[i])));
+    float dy = fmaxf(0.0f, fmaxf(obstacles->y[i] - (player->y + player->height),
+                                 player->y - (obstacles->y[i] +
+                                              obstacles->h[i])));
+    nearest = fminf(nearest, sqrtf(dx * dx + dy * dy));
+  }
+  return nearest;
+}
+
+static void InspectCollision(RewindBuffer *rewind, GameState *view,
+                             uint64_t step) {
+  printf("before the first collision (step %llu):\n",
+         (unsigned long long)step);
+  printf("  %8s %8s %8s %10s\n", "step", "x", "y", "nearest");
+  for (uint64_t s = step >= INSPECT_STEPS ? step - INSPECT_STEPS : 0;
+       s <= step; s++) {
+    if (!RewindSeek(rewind, s, view))
+      continue;
+    printf("  %8llu %8.1f %8.1f %10.1f\n", (unsigned long long)s,
+           view->player.rect.x, view->player.rect.y, NearestObstacle(view));
+  }
+}
+
+static SimInput BotInput(const GameState *state) {
+  SimInput input = BotReflex(state);
+  if (state->gameOver)
+    input |= SIM_INPUT_RESTART;
+  return input;
+}
+
+int main(int argc, char **argv) {
+  long long ticks = argc > 1 ? atoll(argv[1]) : 36000;
+  int swarm = argc > 2 ? atoi(argv[2]) : 0;
+  double budgetMb = argc > 3 ? atof(argv[3]) : 16.0;
+  uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+  if (ticks < 2 || budgetMb <= 0.0) {
+    fprintf(stderr, "need at least 2 ticks and a positive budget\n");
+    return 1;
+  }
+
+  GameState game, view;
+  bool ready = swarm > 0 ? SimInitSwarm(&game, 800, 600, seed, swarm) &&
+                               SimInitSwarm(&view, 800, 600, seed, swarm)
+                         : SimInit(&game, 800, 600, seed) &&
+                               SimInit(&view, 800, 600, seed);
+  RewindBuffer rewind;
+  uint64_t *hashes = malloc((size_t)ticks * sizeof(uint64_t));
+  SimInput *inputs = malloc((size_t)ticks * sizeof(SimInput));
+  if (!ready || !hashes || !inputs ||
+      !RewindInit(&rewind, (size_t)(budgetMb * 1024 * 1024),
+                  REWIND_KEYFRAME_INTERVAL)) {
+    fprintf(stderr, "Error allocating the game state and history\n");
+    return 1;
+  }
+
+  // Step t of the history is the state after inputs[t], with hashes[t]
+  bool inspected = false;
+  uint64_t appendNs = 0;
+  for (long long t = 0; t < ticks; t++) {
+    inputs[t] = BotInput(&game);
+    SimStep(&game, inputs[t], SIM_DT);
+    hashes[t] = SimHash(&game);
+
+    uint64_t start = ProfilerNow();
+    if (!RewindAppend(&rewind, &game)) {
+      fprintf(stderr, "A snapshot doesn't fit in %.1f MB\n", budgetMb);
+      return 1;
+    }
+    appendNs += ProfilerNow() - start;
+
+    if (game.events[SIM_EVENT_COLLISION] && !inspected) {
+      InspectCollision(&rewind, &view, (uint64_t)t);
+      inspected = true;
+    }
+  }
+
+  RewindStats stats = RewindGetStats(&rewind);
+  printf("ticks:            %lld\n", ticks);
+  printf("held:             %lld steps (%.1f s) in %.2f of %.2f MB\n",
+         (long long)stats.steps, stats.seconds, stats.bytesUsed / 1048576.0,
+         stats.budget / 1048576.0);
+  printf("history rate:     %.1f KB/s (%.1f s per budget)\n",
+         stats.bytesPerSecond / 1024.0, stats.secondsPerBudget);
+  printf("compression:      %.1fx against full snapshots, %.0f%% keyframes\n",
+         stats.compression, 100.0 * stats.keyframeShare);
+  printf("append:           %.2f us/step\n", appendNs / 1e3 / ticks);
+
+  // Every held step, backwards (the rewind direction) and then at random
+  long long mismatches = 0;
+  uint64_t seekNs = 0;
+  long long seeks = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int64_t k = 0; k < stats.steps; k++) {
+      uint64_t step = pass == 0 ? stats.newestStep - (uint64_t)k
+                                : stats.oldestStep +
+                                      (uint64_t)rand() % (uint64_t)stats.steps;
+      uint64_t start = ProfilerNow();
+      bool ok = RewindSeek(&rewind, step, &view);
+      seekNs += ProfilerNow() - start;
+      seeks++;
+      if (!ok || SimHash(&view) != hashes[step])
+        mismatches++;
+    }
+  }
+  printf("seek:             %.2f us (%lld seeks)\n",
+         seeks ? seekNs / 1e3 / seeks : 0.0, seeks);
+
+  // Go back halfway and play the same inputs again
+  uint64_t middle = stats.oldestStep + (uint64_t)stats.steps / 2;
+  if (!RewindTruncate(&rewind, middle) || !RewindSeek(&rewind, middle, &game))
+    mismatches++;
+  for (uint64_t step = middle + 1; step <= stats.newestStep; step++) {
+    SimStep(&game, inputs[step], SIM_DT);
+    if (!RewindAppend(&rewind, &game) || SimHash(&game) != hashes[step])
+      mismatches++;
+  }
+  if (!RewindSeek(&rewind, stats.newestStep, &view) ||
+      SimHash(&view) != hashes[stats.newestStep])
+    mismatches++;
+
+  RewindFree(&rewind);
+  SimFree(&game);
+  SimFree(&view);
+  free(hashes);
+  free(inputs);
+  if (mismatches) {
+    fprintf(stderr, "%lld steps don't match their hash\n", mismatches);
+    return 1;
+  }
+  printf("all held steps match their hashes\n");
+  return 0;
+}
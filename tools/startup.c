@@ -0,0 +1,104 @@
+#include "assets.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Time until the game's assets are loaded, without a window: the loose files
+// decoded by raylib (the old startup path) against the pre-decoded bundle.
+// Only the CPU side is timed, uploading to the GPU and the audio device costs
+// the same either way. Also checks that both give the same decoded data.
+//
+// usage: raylibLearn_startup [bundle] [resources dir] [runs]
+
+#define MAX_RUNS 100
+
+static int CompareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static bool SameAsset(AssetLoader *a, AssetLoader *b, int i) {
+  Wave wa = AssetsWave(a, i), wb = AssetsWave(b, i);
+  if (wa.data || wb.data) {
+    size_t size = (size_t)wa.frameCount * wa.channels * (wa.sampleSize / 8);
+    return wa.data && wb.data && wa.frameCount == wb.frameCount &&
+           wa.sampleRate == wb.sampleRate && wa.sampleSize == wb.sampleSize &&
+           wa.channels == wb.channels && memcmp(wa.data, wb.data, size) == 0;
+  }
+  Image ia = AssetsImage(a, i), ib = AssetsImage(b, i);
+  return ia.data && ib.data && ia.width == ib.width &&
+         ia.height == ib.height && ia.format == ib.format &&
+         memcmp(ia.data, ib.data,
+                (size_t)GetPixelDataSize(ia.width, ia.height, ia.format)) ==
+             0;
+}
+
+static bool AllLoaded(AssetLoader *loader) {
+  for (int i = 0; i < ASSET_COUNT; i++) {
+    if (!AssetsWave(loader, i).data && !AssetsImage(loader, i).data)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+  const char *bundlePath = argc > 1 ? argv[1]
+                                    : TextFormat("%s%s",
+                                                 GetApplicationDirectory(),
+                                                 RESOURCE_BUNDLE);
+  const char *dir = argc > 2 ? argv[2] : RESOURCE_DIR;
+  int runs = argc > 3 ? atoi(argv[3]) : 10;
+  if (runs < 1 || runs > MAX_RUNS) {
+    fprintf(stderr, "runs must be 1..%d\n", MAX_RUNS);
+    return 1;
+  }
+
+  double looseMs[MAX_RUNS], bundleMs[MAX_RUNS];
+  for (int run = 0; run < runs; run++) {
+    // One at a time, so they don't compete for the disk and the cores
+    AssetLoader *loose =
+        AssetsLoadAsync(NULL, dir, gameAssetNames, ASSET_COUNT);
+    if (loose)
+      AssetsWait(loose);
+    AssetLoader *packed =
+        AssetsLoadAsync(bundlePath, dir, gameAssetNames, ASSET_COUNT);
+    if (!loose || !packed) {
+      fprintf(stderr, "Error starting the loader threads\n");
+      return 1;
+    }
+    AssetsWait(packed);
+
+    if (run == 0) {
+      if (!AllLoaded(loose)) {
+        fprintf(stderr, "Error loading the files in %s\n", dir);
+        return 1;
+      }
+      if (!AssetsFromBundle(packed)) {
+        fprintf(stderr, "Error opening %s\n", bundlePath);
+        return 1;
+      }
+      for (int i = 0; i < ASSET_COUNT; i++) {
+        if (!SameAsset(loose, packed, i)) {
+          fprintf(stderr, "%s differs between the bundle and %s\n",
+                  gameAssetNames[i], dir);
+          return 1;
+        }
+      }
+    }
+    looseMs[run] = AssetsLoadMs(loose);
+    bundleMs[run] = AssetsLoadMs(packed);
+    AssetsClose(loose);
+    AssetsClose(packed);
+  }
+
+  qsort(looseMs, (size_t)runs, sizeof(double), CompareDoubles);
+  qsort(bundleMs, (size_t)runs, sizeof(double), CompareDoubles);
+  double loose = looseMs[runs / 2], bundle = bundleMs[runs / 2];
+  printf("assets:       %d\n", ASSET_COUNT);
+  printf("runs:         %d\n", runs);
+  printf("loose files:  %.3f ms median, %.3f ms min\n", loose, looseMs[0]);
+  printf("bundle:       %.3f ms median, %.3f ms min\n", bundle, bundleMs[0]);
+  printf("speedup:      %.1fx\n", bundle > 0 ? loose / bundle : 0.0);
+  return 0;
+}